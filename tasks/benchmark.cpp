@@ -0,0 +1,420 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "grammar.h"
+#include "lexer.h"
+#include "parse_tree.h"
+#include "pl0_descent.h"
+#include "pl0_grammar.h"
+#include "predict_table.h"
+#include "program_generator.h"
+#include "slr_parser.h"
+#include "source.h"
+#include "table_image.h"
+#include "thread_pool.h"
+#include "token_buffer.h"
+#include "token_source.h"
+
+// Times each front-end stage on inputs of growing size and prints one row per
+// stage and input, as a table and optionally as JSON:
+//
+//   benchmark [--max-size=BYTES] [--repeat=N] [--threads=N] [--json[=FILE]]
+//
+// A row holds the best of N runs, the throughput derived from it and the heap
+// allocations made by a single run. With --threads above 1 the grammar
+// analyses run on a pool of that many workers.
+
+static size_t allocations = 0, allocated_bytes = 0;
+
+void *operator new(size_t size) {
+  allocations++;
+  allocated_bytes += size;
+  if (void *p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+// Out of line so GCC does not pair the inlined free() with new expressions
+// and warn about a mismatch.
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+  std::free(p);
+}
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept {
+  std::free(p);
+}
+
+struct Result {
+  std::string stage, input;
+  // Work per run in unit, e.g. source bytes or nonterminals.
+  size_t size;
+  std::string unit;
+  double seconds;
+  size_t allocations, bytes;
+
+  double throughput() const {
+    double amount = unit == "B" ? size / 1e6 : size;
+    return seconds > 0 ? amount / seconds : 0;
+  }
+  std::string throughputUnit() const {
+    return (unit == "B" ? "MB" : unit) + "/s";
+  }
+};
+
+// Runs setup() untimed and then run(state) timed, repeat times. Allocations
+// are counted over the last timed run.
+template <typename Setup, typename Run>
+Result measure(const std::string &stage, const std::string &input,
+               size_t size, const std::string &unit, int repeat, Setup setup,
+               Run run) {
+  Result result{stage, input, size, unit, 0, 0, 0};
+  for (int i = 0; i < repeat; i++) {
+    auto state = setup();
+    size_t count = allocations, bytes = allocated_bytes;
+    auto begin = std::chrono::steady_clock::now();
+    run(state);
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - begin).count();
+    if (i == 0 || seconds < result.seconds)
+      result.seconds = seconds;
+    result.allocations = allocations - count;
+    result.bytes = allocated_bytes - bytes;
+  }
+  return result;
+}
+
+// A random, valid PL/0 program of about size bytes. The seed is fixed so
+// runs compare like with like.
+std::string syntheticProgram(size_t size) {
+  GeneratorOptions options;
+  options.size = size;
+  return ProgramGenerator(options).generate();
+}
+
+// Name of the nonterminal for level i of the synthetic grammars.
+static std::string level(int i) { return "L" + std::to_string(i); }
+
+// Right-recursive expression grammar with levels binary and prefix
+// operators, which is LL(1):  N -> un N | M N',  N' -> op M N' | ε,  and the
+// last level -> ( L0 ) | z. Every level adds its own terminal to FIRST, so
+// the sets grow along the whole chain.
+SymbolGrammarInputType llExpressionGrammar(int levels) {
+  SymbolGrammarInputType g;
+  for (int i = 0; i < levels; i++) {
+    std::string n = level(i), rest = n + "'", next = level(i + 1);
+    g.push_back({n, {{"un" + std::to_string(i), n}, {next, rest}}});
+    g.push_back({rest, {{"op" + std::to_string(i), next, rest}, {}}});
+  }
+  g.push_back({level(levels), {{"(", level(0), ")"}, {"z"}}});
+  return g;
+}
+
+// The left-recursive form of the same grammar, augmented with L0' for the
+// SLR parser:  N -> N op M | M.
+SymbolGrammarInputType lrExpressionGrammar(int levels) {
+  SymbolGrammarInputType g;
+  g.push_back({level(0) + "'", {{level(0)}}});
+  for (int i = 0; i < levels; i++) {
+    std::string n = level(i), next = level(i + 1);
+    g.push_back({n, {{n, "op" + std::to_string(i), next}, {next}}});
+  }
+  g.push_back({level(levels), {{"(", level(0), ")"}, {"z"}}});
+  return g;
+}
+
+// Parse steps, expansions and matches on the stack plus the operators the
+// expression parser applies, for the same input with and without
+// expression mode.
+struct StepCount {
+  std::string input;
+  size_t tokens, table, expressions;
+};
+
+struct GrammarCase {
+  std::string name;
+  std::function<Grammar *()> build;
+};
+
+void runLexer(std::vector<Result> &results, int repeat,
+              const std::vector<size_t> &sizes) {
+  for (size_t size : sizes) {
+    std::string code = syntheticProgram(size);
+    for (LexerEngine engine : {TABLE_ENGINE, BRANCHY_ENGINE}) {
+      std::string stage = engine == TABLE_ENGINE ? "lex" : "lex-branchy";
+      results.push_back(measure(
+          stage, "pl0-" + std::to_string(size), code.size(), "B", repeat,
+          [] { return 0; },
+          [&](int &) {
+            Lexer lexer(code, engine);
+            size_t tokens = 0;
+            while (lexer.getTokenType() != END)
+              tokens++;
+            if (tokens == 0)
+              throw std::runtime_error("Lexer produced no tokens");
+          }));
+    }
+  }
+}
+
+void runGrammar(std::vector<Result> &results, int repeat,
+                const std::vector<GrammarCase> &cases,
+                WorkStealingPool *pool) {
+  using GrammarPtr = std::unique_ptr<Grammar>;
+  for (const auto &c : cases) {
+    size_t size = GrammarPtr(c.build())->getNonterminalNames().size();
+    auto fresh = [&] {
+      GrammarPtr G(c.build());
+      G->setAnalysisPool(pool);
+      return G;
+    };
+    // Each kind of set is computed for the whole grammar on its first lookup.
+    results.push_back(measure("first", c.name, size, "nonterm", repeat, fresh,
+                              [](GrammarPtr &G) {
+                                G->getFirstSet(G->getStart());
+                              }));
+    results.push_back(measure(
+        "follow", c.name, size, "nonterm", repeat,
+        [&] {
+          GrammarPtr G = fresh();
+          G->getFirstSet(G->getStart());
+          return G;
+        },
+        [](GrammarPtr &G) { G->getFollowSet(G->getStart()); }));
+    results.push_back(measure(
+        "select", c.name, size, "nonterm", repeat,
+        [&] {
+          GrammarPtr G = fresh();
+          G->getFollowSet(G->getStart());
+          return G;
+        },
+        [](GrammarPtr &G) { G->getAllSelectSet(); }));
+    results.push_back(measure("predict-table", c.name, size, "nonterm",
+                              repeat, fresh, [](GrammarPtr &G) {
+                                TableType table;
+                                buildPredcitTable(*G, table);
+                              }));
+    // What --tables saves: building and analysing the grammar from scratch,
+    // against checking a stored image and reading both back from it.
+    results.push_back(measure(
+        "build-table", c.name, size, "nonterm", repeat, [] { return 0; },
+        [&](int &) {
+          GrammarPtr G = fresh();
+          PredictCells table(*G);
+        }));
+    // The PL/0 table is also worked out at compile time, which leaves only
+    // the grammar to build.
+    if (c.name == "pl0")
+      results.push_back(measure(
+          "static-table", c.name, size, "nonterm", repeat, [] { return 0; },
+          [&](int &) {
+            GrammarPtr G = fresh();
+            PredictCells table(PL0_GRAMMAR.predictCells(),
+                               PL0_GRAMMAR.terminalCount());
+          }));
+    // Adding an alternative to the start symbol and taking it out again,
+    // keeping the analyses and the table up to date, against all of the
+    // above. Its terminal is added once beforehand, as a tool iterating on
+    // a grammar would have it already.
+    auto edit = [](Grammar &G, TableType &table) {
+      int rule = G.addProduction(G.getSymbols().name(G.getStart()),
+                                 std::vector<std::string>{"edit"});
+      updatePredictTable(G, table);
+      G.removeProduction(rule);
+      updatePredictTable(G, table);
+    };
+    results.push_back(measure(
+        "edit", c.name, size, "nonterm", repeat,
+        [&] {
+          auto state = std::make_pair(fresh(), TableType());
+          edit(*state.first, state.second);
+          return state;
+        },
+        [&](std::pair<GrammarPtr, TableType> &state) {
+          edit(*state.first, state.second);
+        }));
+    std::string image = TableImage::build(*fresh(), false);
+    results.push_back(measure(
+        "image-load", c.name, size, "nonterm", repeat, [&] { return image; },
+        [](std::string &bytes) {
+          TableImage loaded(std::move(bytes));
+          Grammar G = loaded.grammar();
+          PredictCells table(std::move(loaded));
+        }));
+  }
+}
+
+void runSLR(std::vector<Result> &results, int repeat,
+            const std::vector<GrammarCase> &cases) {
+  using GrammarPtr = std::unique_ptr<Grammar>;
+  for (const auto &c : cases) {
+    size_t size = GrammarPtr(c.build())->getNonterminalNames().size();
+    results.push_back(measure(
+        "slr-item-sets", c.name, size, "nonterm", repeat,
+        [&] { return GrammarPtr(c.build()); },
+        [](GrammarPtr &G) { SLRParser parser(G.get(), false); }));
+  }
+}
+
+void runParser(std::vector<Result> &results, std::vector<StepCount> &steps,
+               int repeat, const std::vector<size_t> &sizes) {
+  Grammar G = *getGrammer();
+  for (size_t size : sizes) {
+    std::string code = syntheticProgram(size);
+    TokenBuffer tokens(code.size());
+    Lexer lexer(code);
+    for (TokenType type; (type = lexer.getTokenType()) != END;)
+      tokens.push_back(lexer.buildToken(type));
+    std::string name = "pl0-" + std::to_string(size);
+    PredictTable table(G), expressions(G);
+    expressions.setExpressionMode(true);
+    for (PredictTable *parser : {&table, &expressions}) {
+      results.push_back(measure(
+          parser == &table ? "ll1-parse" : "ll1-expr-parse", name,
+          code.size(), "B", repeat,
+          [&] {
+            parser->clear_stack();
+            return TokenSource(code, tokens);
+          },
+          [&](TokenSource &input) { parser->analysis(input, false); }));
+    }
+    // Building the parse tree as well, into an arena kept between runs.
+    ParseTree tree;
+    PredictTable builder(G);
+    builder.buildTree(&tree);
+    results.push_back(measure(
+        "ll1-tree-parse", name, code.size(), "B", repeat,
+        [&] {
+          builder.clear_stack();
+          return TokenSource(code, tokens);
+        },
+        [&](TokenSource &input) { builder.analysis(input, false); }));
+    // Every token is matched once either way.
+    steps.push_back({name, tokens.size(),
+                     table.expansionCount() + tokens.size(),
+                     expressions.expansionCount() + tokens.size() +
+                         expressions.quadruples().size()});
+    // The same parse by the recursive-descent parser generated from the
+    // table.
+    results.push_back(measure(
+        "descent-parse", name, code.size(), "B", repeat,
+        [&] { return TokenSource(code, tokens); },
+        [&](TokenSource &input) { PL0Descent<TokenSource>(input).parse(); }));
+  }
+}
+
+void printTable(const std::vector<Result> &results) {
+  std::cout << std::left << std::setw(15) << "stage" << std::setw(14)
+            << "input" << std::right << std::setw(10) << "size"
+            << std::setw(12) << "best ms" << std::setw(22) << "throughput"
+            << std::setw(12) << "allocs" << std::setw(14) << "bytes" << '\n';
+  for (const auto &r : results) {
+    std::ostringstream rate;
+    rate << std::fixed << std::setprecision(1) << r.throughput() << ' '
+         << r.throughputUnit();
+    std::cout << std::left << std::setw(15) << r.stage << std::setw(14)
+              << r.input << std::right << std::setw(10) << r.size
+              << std::setw(12) << std::fixed << std::setprecision(3)
+              << r.seconds * 1e3 << std::setw(22) << rate.str()
+              << std::setw(12) << r.allocations << std::setw(14) << r.bytes
+              << '\n';
+  }
+}
+
+void printSteps(const std::vector<StepCount> &steps) {
+  std::cout << '\n'
+            << std::left << std::setw(15) << "steps/token" << std::setw(14)
+            << "input" << std::right << std::setw(10) << "tokens"
+            << std::setw(12) << "table" << std::setw(12) << "expr mode"
+            << std::setw(12) << "saved" << '\n';
+  for (const auto &s : steps) {
+    double table = double(s.table) / s.tokens,
+           expressions = double(s.expressions) / s.tokens;
+    std::cout << std::left << std::setw(15) << "" << std::setw(14) << s.input
+              << std::right << std::setw(10) << s.tokens << std::fixed
+              << std::setprecision(2) << std::setw(12) << table
+              << std::setw(12) << expressions << std::setw(11)
+              << 100 * (1 - expressions / table) << "%\n";
+  }
+}
+
+void printJSON(std::ostream &os, const std::vector<Result> &results) {
+  os << "[\n";
+  for (size_t i = 0; i < results.size(); i++) {
+    const auto &r = results[i];
+    os << "  {\"stage\": \"" << r.stage << "\", \"input\": \"" << r.input
+       << "\", \"size\": " << r.size << ", \"unit\": \"" << r.unit
+       << "\", \"seconds\": " << std::scientific << std::setprecision(6)
+       << r.seconds << ", \"throughput\": " << r.throughput()
+       << ", \"throughput_unit\": \"" << r.throughputUnit()
+       << "\", \"allocations\": " << r.allocations
+       << ", \"bytes\": " << r.bytes << "}"
+       << (i + 1 < results.size() ? ",\n" : "\n");
+  }
+  os << "]\n";
+}
+
+int main(int argc, char *argv[]) {
+  const char *max_size_arg = getFlagValue(argc, argv, "--max-size=");
+  const char *repeat_arg = getFlagValue(argc, argv, "--repeat=");
+  const char *threads_arg = getFlagValue(argc, argv, "--threads=");
+  size_t max_size = max_size_arg ? std::strtoull(max_size_arg, nullptr, 10)
+                                 : 16u << 20;
+  int repeat = repeat_arg ? std::atoi(repeat_arg) : 5;
+  int threads = threads_arg ? std::atoi(threads_arg) : 1;
+  if (max_size == 0 || repeat <= 0 || threads <= 0)
+    throw std::runtime_error(
+        "--max-size, --repeat and --threads must be positive");
+  std::unique_ptr<WorkStealingPool> pool;
+  if (threads > 1)
+    pool = std::make_unique<WorkStealingPool>(threads);
+
+  // Inputs grow by 4x from 64KiB up to max_size.
+  std::vector<size_t> sizes;
+  for (size_t size = 64 << 10; size < max_size; size *= 4)
+    sizes.push_back(size);
+  sizes.push_back(max_size);
+
+  std::vector<GrammarCase> ll_grammars{{"pl0", getGrammer}};
+  for (int levels : {4, 16, 64, 256, 1024, 4096})
+    ll_grammars.push_back({"ll-expr-" + std::to_string(levels), [levels] {
+                             return buildGrammar(level(0),
+                                                 llExpressionGrammar(levels));
+                           }});
+  std::vector<GrammarCase> lr_grammars{{"pl0", getGrammer}};
+  for (int levels : {4, 16, 64})
+    lr_grammars.push_back({"lr-expr-" + std::to_string(levels), [levels] {
+                             return buildGrammar(level(0) + "'",
+                                                 lrExpressionGrammar(levels));
+                           }});
+
+  std::vector<Result> results;
+  std::vector<StepCount> steps;
+  runLexer(results, repeat, sizes);
+  runGrammar(results, repeat, ll_grammars, pool.get());
+  runSLR(results, repeat, lr_grammars);
+  runParser(results, steps, repeat, sizes);
+
+  printTable(results);
+  printSteps(steps);
+  const char *json = getFlagValue(argc, argv, "--json");
+  if (json && *json == '=') {
+    std::ofstream out(json + 1);
+    if (!out)
+      throw std::runtime_error("Cannot write " + std::string(json + 1));
+    printJSON(out, results);
+  } else if (json && *json == '\0') {
+    printJSON(std::cout, results);
+  }
+  return 0;
+}
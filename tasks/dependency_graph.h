@@ -0,0 +1,181 @@
+#ifndef COMPILEWORK_DEPENDENCY_GRAPH_H
+#define COMPILEWORK_DEPENDENCY_GRAPH_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "thread_pool.h"
+
+// The nodes of one strongly connected component.
+struct NodeSpan {
+  const int *first, *last;
+  const int *begin() const { return first; }
+  const int *end() const { return last; }
+  size_t size() const { return last - first; }
+  int operator[](size_t i) const { return first[i]; }
+};
+
+// Strongly connected components stored back to back: component c is
+// nodes[offsets[c]] up to nodes[offsets[c + 1]], and of[node] is c.
+struct Components {
+  std::vector<int> nodes, offsets{0}, of;
+  size_t size() const { return offsets.size() - 1; }
+  NodeSpan operator[](size_t c) const {
+    return {nodes.data() + offsets[c], nodes.data() + offsets[c + 1]};
+  }
+};
+
+// A directed graph over nodes 0..size()-1, where an edge from -> to means
+// that to's value is computed from from's. The grammar analyses build one
+// per kind of set and solve it a strongly connected component at a time.
+class DependencyGraph {
+public:
+  DependencyGraph(size_t nodes = 0) : edges(nodes), reverse(nodes) {}
+
+  size_t size() const { return edges.size(); }
+  void addEdge(int from, int to) {
+    edges[from].push_back(to);
+    reverse[to].push_back(from);
+  }
+  const std::vector<int> &successors(int node) const { return edges[node]; }
+  const std::vector<int> &predecessors(int node) const {
+    return reverse[node];
+  }
+
+  // The strongly connected components, each listed before every component
+  // it has an edge to, so a component's inputs from outside it are final by
+  // the time it is reached. Tarjan's algorithm with an explicit stack, so
+  // long chains of nonterminals cannot overflow the call stack.
+  Components components() const {
+    const int n = edges.size();
+    std::vector<int> index(n, -1), low(n), stack;
+    std::vector<bool> on_stack(n, false);
+    // Each frame is a node and the next of its edges to follow.
+    std::vector<std::pair<int, size_t>> frames;
+    // Tarjan finishes a component after everything it reaches, so they are
+    // collected back to front and reversed at the end.
+    Components result;
+    result.nodes.reserve(n);
+    std::vector<int> sizes;
+    int counter = 0;
+    auto open = [&](int v) {
+      index[v] = low[v] = counter++;
+      stack.push_back(v);
+      on_stack[v] = true;
+      frames.emplace_back(v, 0);
+    };
+    for (int root = 0; root < n; root++) {
+      if (index[root] >= 0)
+        continue;
+      open(root);
+      while (!frames.empty()) {
+        int v = frames.back().first;
+        size_t next = frames.back().second;
+        if (next < edges[v].size()) {
+          frames.back().second++;
+          int w = edges[v][next];
+          if (index[w] < 0)
+            open(w);
+          else if (on_stack[w])
+            low[v] = std::min(low[v], index[w]);
+          continue;
+        }
+        frames.pop_back();
+        if (!frames.empty()) {
+          int &parent = low[frames.back().first];
+          parent = std::min(parent, low[v]);
+        }
+        if (low[v] == index[v]) {
+          size_t before = result.nodes.size();
+          int w;
+          do {
+            w = stack.back();
+            stack.pop_back();
+            on_stack[w] = false;
+            result.nodes.push_back(w);
+          } while (w != v);
+          sizes.push_back(result.nodes.size() - before);
+        }
+      }
+    }
+    std::reverse(result.nodes.begin(), result.nodes.end());
+    result.offsets.reserve(sizes.size() + 1);
+    for (size_t c = sizes.size(); c-- > 0;)
+      result.offsets.push_back(result.offsets.back() + sizes[c]);
+    result.of.resize(n);
+    for (size_t c = 0; c < result.size(); c++) {
+      for (int v : result[c])
+        result.of[v] = c;
+    }
+    return result;
+  }
+
+private:
+  std::vector<std::vector<int>> edges, reverse;
+};
+
+// Below this many components a graph is solved on the calling thread; a
+// component is typically a few set unions, far cheaper than a submit.
+constexpr size_t MIN_PARALLEL_COMPONENTS = 256;
+
+// Calls solve(c) for every component c once every component with an edge
+// into c has been solved. Without a pool, with a single worker or for a
+// small graph, that is simply the components' order. On a pool, a
+// component is submitted when its last input is solved; the first
+// component a task makes ready runs next on the same task, so chains do not
+// pay for a submit per link.
+template <typename Solve>
+void forEachComponent(const DependencyGraph &graph,
+                      const Components &components, WorkStealingPool *pool,
+                      Solve solve) {
+  if (!pool || pool->size() <= 1 ||
+      components.size() < MIN_PARALLEL_COMPONENTS) {
+    for (size_t c = 0; c < components.size(); c++)
+      solve(c);
+    return;
+  }
+  // Inputs of each component still to be solved, counted per edge.
+  std::vector<std::atomic<int>> waiting(components.size());
+  for (size_t c = 0; c < components.size(); c++) {
+    for (int v : components[c]) {
+      for (int w : graph.successors(v)) {
+        if (components.of[w] != static_cast<int>(c))
+          waiting[components.of[w]]++;
+      }
+    }
+  }
+  std::function<void(int)> run = [&](int c) {
+    while (c >= 0) {
+      solve(c);
+      int next = -1;
+      for (int v : components[c]) {
+        for (int w : graph.successors(v)) {
+          int d = components.of[w];
+          if (d == c || --waiting[d] != 0)
+            continue;
+          if (next < 0)
+            next = d;
+          else
+            pool->submit([&run, d] { run(d); });
+        }
+      }
+      c = next;
+    }
+  };
+  // Counts start dropping as soon as the first task runs, so the sources
+  // are picked out before any is submitted.
+  std::vector<int> sources;
+  for (size_t c = 0; c < components.size(); c++) {
+    if (waiting[c] == 0)
+      sources.push_back(c);
+  }
+  for (int c : sources)
+    pool->submit([&run, c] { run(c); });
+  pool->wait();
+}
+
+#endif
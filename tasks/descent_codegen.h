@@ -0,0 +1,195 @@
+#ifndef COMPILEWORK_DESCENT_CODEGEN_H
+#define COMPILEWORK_DESCENT_CODEGEN_H
+
+#include <cctype>
+#include <cstddef>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "grammar.h"
+#include "table_image.h"
+
+// Writes an LL(1) grammar out as a standalone recursive-descent parser in a
+// C++ header. The parser is a class template over the parser input, like
+// PredictTable::analysis, with a function per nonterminal that switches on
+// the lookahead's terminal index, the cases of a production being the
+// terminals table predicts it on. A production whose last symbol is its own
+// nonterminal loops instead of recursing, so long lists do not run the
+// stack down. Terminals must be single characters, which a 256-entry array
+// maps to their index.
+class DescentCodegen {
+public:
+  DescentCodegen(Grammar &G, const PredictCells &table)
+      : G(G), symbols(G.getSymbols()), table(table) {
+    if (symbols.terminals().size() > 127)
+      throw std::runtime_error("Too many terminals for int8_t kinds");
+    for (Symbol t : symbols.terminals()) {
+      if (t != SymbolTable::EPSILON && symbols.name(t).size() != 1)
+        throw std::runtime_error("Terminal is not one character: " +
+                                 symbols.name(t));
+    }
+  }
+
+  // Writes the header defining class name; what it was generated from is
+  // noted at its top.
+  void write(std::ostream &out, const std::string &name,
+             const std::string &source) {
+    std::string guard = "COMPILEWORK_" + snakeCase(name) + "_H";
+    out << "// Generated by gen_parser from " << source << "; do not edit.\n"
+        << "#ifndef " << guard << "\n#define " << guard << "\n\n"
+        << "#include <cstddef>\n#include <cstdint>\n#include <stdexcept>\n\n"
+        << "// Recursive-descent parser for the grammar with start symbol "
+        << symbols.name(G.getStart()) << ".\n"
+        << "template <typename Input> class " << name << " {\n"
+        << "public:\n"
+        << "  explicit " << name << "(Input &input) : input(input) {}\n\n"
+        << "  // Parses input, which must be a sentence, and returns how "
+           "many\n"
+        << "  // productions it expanded.\n"
+        << "  size_t parse() {\n"
+        << "    expansions = 0;\n"
+        << "    lookahead = kind();\n"
+        << "    " << function(G.getStart()) << "();\n"
+        << "    if (lookahead != " << symbols.index(SymbolTable::END) << ")\n"
+        << "      error();\n"
+        << "    return expansions;\n"
+        << "  }\n\n"
+        << "private:\n"
+        << "  int kind() {\n"
+        << "    return KINDS[static_cast<unsigned char>(input.peek()[0])];\n"
+        << "  }\n\n"
+        << "  void advance() {\n"
+        << "    input.advance();\n"
+        << "    lookahead = kind();\n"
+        << "  }\n\n"
+        << "  void expect(int t) {\n"
+        << "    if (lookahead != t)\n"
+        << "      error();\n"
+        << "    advance();\n"
+        << "  }\n\n"
+        << "  [[noreturn]] static void error() {\n"
+        << "    throw std::runtime_error(\"PredictTable wrong!\\n\");\n"
+        << "  }\n";
+    for (Symbol non : symbols.nonterminals())
+      writeFunction(out, non);
+    writeKinds(out);
+    out << "\n  Input &input;\n"
+        << "  int lookahead;\n"
+        << "  size_t expansions;\n"
+        << "};\n\n"
+        << "#endif\n";
+  }
+
+private:
+  // PL0Descent -> PL0_DESCENT.
+  static std::string snakeCase(const std::string &name) {
+    std::string snake;
+    for (size_t i = 0; i < name.size(); i++) {
+      if (i > 0 && std::isupper(name[i]) && !std::isupper(name[i - 1]))
+        snake += '_';
+      snake += std::toupper(name[i]);
+    }
+    return snake;
+  }
+
+  // parse followed by the nonterminal's name, with ' spelled Prime and any
+  // other character that cannot be in an identifier by its code.
+  std::string function(Symbol non) const {
+    std::string f = "parse";
+    for (char c : symbols.name(non)) {
+      if (c == '\'')
+        f += "Prime";
+      else if (std::isalnum(static_cast<unsigned char>(c)) || c == '_')
+        f += c;
+      else
+        f += "_" + std::to_string(static_cast<unsigned char>(c));
+    }
+    return f;
+  }
+
+  // A terminal for a comment; a backslash would continue the line.
+  std::string comment(Symbol t) const {
+    const std::string &name = symbols.name(t);
+    return name == "\\" ? "backslash" : name;
+  }
+
+  bool tailRecursive(int rule) const {
+    SymbolSpan rhs = G.getRhs(rule);
+    return !rhs.empty() && rhs[rhs.size() - 1] == G.getProduction(rule).lhs;
+  }
+
+  void writeFunction(std::ostream &out, Symbol non) {
+    const std::vector<int> &rules = G.getRules(non);
+    int row = symbols.index(non);
+    bool loop = false;
+    for (int rule : rules)
+      loop = loop || tailRecursive(rule);
+    std::string indent = loop ? "      " : "    ";
+    out << "\n  void " << function(non) << "() {\n";
+    if (loop)
+      out << "    for (;;) {\n";
+    out << indent << "switch (lookahead) {\n";
+    for (int rule : rules) {
+      bool predicted = false;
+      for (Symbol t : symbols.terminals()) {
+        if (t == SymbolTable::EPSILON ||
+            table(row, symbols.index(t)) != rule)
+          continue;
+        out << indent << "case " << symbols.index(t) << ": // " << comment(t)
+            << "\n";
+        predicted = true;
+      }
+      if (!predicted)
+        continue;
+      writeRule(out, rule, indent + "  ");
+    }
+    out << indent << "default:\n" << indent << "  error();\n";
+    out << indent << "}\n";
+    if (loop)
+      out << "    }\n";
+    out << "  }\n";
+  }
+
+  // The case body: each symbol in turn, the first one already known to be
+  // the lookahead if it is a terminal.
+  void writeRule(std::ostream &out, int rule, const std::string &indent) {
+    out << indent << "// " << symbols.name(G.getProduction(rule).lhs)
+        << " --> " << ToEpsilon(G.getProductionText(rule)) << "\n"
+        << indent << "expansions++;\n";
+    SymbolSpan rhs = G.getRhs(rule);
+    size_t calls = tailRecursive(rule) ? rhs.size() - 1 : rhs.size();
+    for (size_t i = 0; i < calls; i++) {
+      if (symbols.isNonterminal(rhs[i]))
+        out << indent << function(rhs[i]) << "();\n";
+      else if (i == 0)
+        out << indent << "advance();\n";
+      else
+        out << indent << "expect(" << symbols.index(rhs[i]) << ");\n";
+    }
+    out << indent << (calls < rhs.size() ? "continue;\n" : "return;\n");
+  }
+
+  void writeKinds(std::ostream &out) {
+    std::vector<int> kinds(256, -1);
+    for (Symbol t : symbols.terminals()) {
+      if (t != SymbolTable::EPSILON)
+        kinds[static_cast<unsigned char>(symbols.name(t)[0])] =
+            symbols.index(t);
+    }
+    out << "\n  // Terminal index of each character, or -1.\n"
+        << "  static constexpr int8_t KINDS[256] = {";
+    for (size_t c = 0; c < kinds.size(); c++) {
+      out << (c % 16 == 0 ? "\n      " : " ") << kinds[c]
+          << (c + 1 < kinds.size() ? "," : "");
+    }
+    out << "};\n";
+  }
+
+  Grammar &G;
+  const SymbolTable &symbols;
+  const PredictCells &table;
+};
+
+#endif
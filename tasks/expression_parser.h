@@ -0,0 +1,113 @@
+#ifndef COMPILEWORK_EXPRESSION_PARSER_H
+#define COMPILEWORK_EXPRESSION_PARSER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "quadruple.h"
+
+// The nonterminal ExpressionParser stands in for.
+inline constexpr char EXPRESSION_NONTERMINAL[] = "E";
+
+// Parses a PL/0 expression, E of PL0_PRODUCTIONS, by precedence climbing
+// rather than through E, J, T, K, T', J', L and M on the LL(1) stack:
+//
+//   E -> [+|-] term {(+|-) term}    term -> factor {(*|/) factor}
+//   factor -> b | n | ( E )
+//
+// It writes the quadruples as it goes, one per operator applied, each into
+// a new temporary T1, T2, ..., and leaves the value of the expression in a
+// temporary, an identifier or a number. Needs the input to give the lexeme
+// of the lookahead as well, as lexeme().
+template <typename Input> class ExpressionParser {
+public:
+  ExpressionParser(Input &input, std::vector<Quadruple> &codes)
+      : input(input), codes(codes) {}
+
+  // Parses an expression into place. At a syntax error it returns false
+  // with the input at the token that does not fit.
+  bool parse(std::string &place) {
+    char sign = lookahead();
+    if (sign == '+' || sign == '-')
+      advance();
+    if (!factor(place) || !climb(MULTIPLICATIVE, place))
+      return false;
+    if (sign == '-') {
+      std::string zero = "0";
+      emit('-', zero, std::move(place));
+      place = std::move(zero);
+    }
+    return climb(ADDITIVE, place);
+  }
+
+  // Tokens consumed and operators applied so far, the parse steps taken.
+  size_t stepCount() const { return steps; }
+
+private:
+  enum Precedence { NONE, ADDITIVE, MULTIPLICATIVE };
+
+  static Precedence precedence(char t) {
+    switch (t) {
+    case '+':
+    case '-':
+      return ADDITIVE;
+    case '*':
+    case '/':
+      return MULTIPLICATIVE;
+    default:
+      return NONE;
+    }
+  }
+
+  char lookahead() { return input.peek()[0]; }
+
+  void advance() {
+    input.advance();
+    steps++;
+  }
+
+  // Applies to left the operators that bind at least as tightly as min.
+  bool climb(int min, std::string &left) {
+    for (char op; precedence(op = lookahead()) >= min;) {
+      advance();
+      std::string right;
+      if (!factor(right) || !climb(precedence(op) + 1, right))
+        return false;
+      emit(op, left, std::move(right));
+    }
+    return true;
+  }
+
+  bool factor(std::string &place) {
+    char t = lookahead();
+    if (t == 'b' || t == 'n') {
+      place = input.lexeme();
+      advance();
+      return true;
+    }
+    if (t != '(')
+      return false;
+    advance();
+    if (!parse(place) || lookahead() != ')')
+      return false;
+    advance();
+    return true;
+  }
+
+  // Writes left op right into a new temporary, which left becomes.
+  void emit(char op, std::string &left, std::string right) {
+    std::string temp = "T" + std::to_string(++temps);
+    codes.emplace_back(std::string(1, op), std::move(left), std::move(right),
+                       temp);
+    left = std::move(temp);
+    steps++;
+  }
+
+  Input &input;
+  std::vector<Quadruple> &codes;
+  size_t steps = 0;
+  int temps = 0;
+};
+
+#endif
@@ -0,0 +1,36 @@
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "descent_codegen.h"
+#include "grammar.h"
+#include "pl0_grammar.h"
+#include "source.h"
+#include "table_image.h"
+
+// Writes the recursive-descent parser for the PL/0 grammar, from its
+// compile-time predict table, as a C++ header:
+//
+//   gen_parser [--class=NAME] [--output=FILE]
+//
+// The class is PL0Descent unless named; pl0_descent.h is this program's
+// output with the defaults.
+
+int main(int argc, char *argv[]) {
+  const char *name = getFlagValue(argc, argv, "--class=");
+  std::unique_ptr<Grammar> G(getGrammer());
+  PredictCells table(PL0_GRAMMAR.predictCells(), PL0_GRAMMAR.terminalCount());
+  DescentCodegen codegen(*G, table);
+  std::string source = "the PL/0 grammar";
+  if (const char *path = getFlagValue(argc, argv, "--output=")) {
+    std::ofstream out(path);
+    if (!out)
+      throw std::runtime_error("Cannot write " + std::string(path));
+    codegen.write(out, name ? name : "PL0Descent", source);
+  } else {
+    codegen.write(std::cout, name ? name : "PL0Descent", source);
+  }
+  return 0;
+}
@@ -0,0 +1,71 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "program_generator.h"
+#include "source.h"
+
+// Writes a random PL/0 program for scale testing the lexer and parsers:
+//
+//   generate [--size=BYTES[K|M|G]] [--seed=N] [--comments=P]
+//            [--ident-len=MIN-MAX] [--procedure-depth=N]
+//            [--statement-depth=N] [--expression-depth=N] [--output=FILE]
+//
+// The same options and seed always give the same program.
+
+// Parses a byte count with an optional binary K, M or G suffix.
+size_t parseSize(const char *arg) {
+  char *end;
+  size_t size = std::strtoull(arg, &end, 10);
+  switch (*end) {
+  case 'G':
+    size <<= 10;
+    [[fallthrough]];
+  case 'M':
+    size <<= 10;
+    [[fallthrough]];
+  case 'K':
+    size <<= 10;
+    end++;
+    break;
+  }
+  if (end == arg || *end != '\0' || size == 0)
+    throw std::runtime_error("Bad size " + std::string(arg));
+  return size;
+}
+
+int main(int argc, char *argv[]) {
+  GeneratorOptions options;
+  if (const char *size = getFlagValue(argc, argv, "--size="))
+    options.size = parseSize(size);
+  if (const char *seed = getFlagValue(argc, argv, "--seed="))
+    options.seed = std::strtoull(seed, nullptr, 10);
+  if (const char *density = getFlagValue(argc, argv, "--comments="))
+    options.comment_density = std::atof(density);
+  if (const char *range = getFlagValue(argc, argv, "--ident-len=")) {
+    const char *dash = std::strchr(range, '-');
+    options.min_ident_len = std::atoi(range);
+    options.max_ident_len = dash ? std::atoi(dash + 1) : options.min_ident_len;
+  }
+  if (const char *depth = getFlagValue(argc, argv, "--procedure-depth="))
+    options.procedure_depth = std::atoi(depth);
+  if (const char *depth = getFlagValue(argc, argv, "--statement-depth="))
+    options.statement_depth = std::atoi(depth);
+  if (const char *depth = getFlagValue(argc, argv, "--expression-depth="))
+    options.expression_depth = std::atoi(depth);
+
+  ProgramGenerator generator(options);
+  if (const char *path = getFlagValue(argc, argv, "--output=")) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+      throw std::runtime_error("Cannot write " + std::string(path));
+    generator.generate(out);
+  } else {
+    std::ios::sync_with_stdio(false);
+    generator.generate(std::cout);
+  }
+  return 0;
+}
@@ -0,0 +1,1515 @@
+#ifndef COMPILEWORK_GRAMMAR_H
+#define COMPILEWORK_GRAMMAR_H
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <queue>
+#include <set>
+#include <stack>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "dependency_graph.h"
+#include "terminal_set.h"
+
+#define Epsilon " "
+#define Invalid "<INVALID>"
+
+using GrammarInputType =
+    std::unordered_map<std::string, std::vector<std::string>>;
+// Productions as lists of symbol names, for grammars whose names do not fit
+// the one-character notation.
+using SymbolGrammarInputType =
+    std::vector<std::pair<std::string, std::vector<std::vector<std::string>>>>;
+using SetType = std::unordered_map<std::string, std::set<std::string>>;
+
+class Nonterminal;
+class Terminal;
+class Grammar;
+class TableImage;
+
+// Dense id of a grammar symbol, handed out by SymbolTable.
+using Symbol = int;
+constexpr Symbol NO_SYMBOL = -1;
+constexpr int NO_RULE = -1;
+
+// Predict table rows are indexed by nonterminal, columns by terminal, both
+// as SymbolTable::index(); entries are production ids or NO_RULE.
+using TableType = std::vector<std::vector<int>>;
+
+inline bool isNonterminal(const std::string &name) {
+  return std::isupper(name[0]);
+}
+
+template <typename T>
+inline void concat(std::set<T> &v1, const std::set<T> &v2) {
+  v1.insert(v2.begin(), v2.end());
+}
+
+inline bool isNonterminal(const char &name) { return std::isupper(name); }
+
+inline std::string ToEpsilon(const std::string &var) {
+  return var == Epsilon ? "ε" : var;
+}
+
+inline void printSeperater(int size) {
+  for (int i = 0; i < size; i++) {
+    std::cout << "========";
+  }
+  std::cout << std::endl;
+}
+
+inline void printTab(int size) {
+  for (int i = 0; i < size; i++) {
+    std::cout << '\t';
+  }
+}
+
+// Splits a production in the one-character notation: an uppercase letter,
+// optionally followed by ', is a nonterminal and any other character is a
+// terminal. Epsilon splits into no symbols.
+inline std::vector<std::string> splitProduction(const std::string &production) {
+  std::vector<std::string> names;
+  if (production == Epsilon)
+    return names;
+  for (size_t i = 0; i < production.size(); i++) {
+    std::string name = {production[i]};
+    if (isNonterminal(production[i]) && i + 1 < production.size() &&
+        production[i + 1] == '\'')
+      name += production[++i];
+    names.push_back(name);
+  }
+  return names;
+}
+
+// How a production is written: in the one-character notation when that
+// splits back into the same names, and with the names separated by spaces
+// otherwise.
+inline std::string productionText(const std::vector<std::string> &names) {
+  if (names.empty())
+    return Epsilon;
+  std::string compact, spaced;
+  for (const auto &name : names) {
+    compact += name;
+    spaced += (spaced.empty() ? "" : " ") + name;
+  }
+  return splitProduction(compact) == names ? compact : spaced;
+}
+
+template <typename T>
+inline void assertNotHasKey(const std::string &key,
+                            std::unordered_map<std::string, T> dict) {
+  auto it = dict.find(key);
+  if (it != dict.end())
+    throw std::runtime_error("Already has Key " + key);
+}
+
+template <typename T> inline void printStack(std::stack<T> t) {
+  std::vector<T> temp;
+  while (!t.empty()) {
+    temp.push_back(t.top());
+    t.pop();
+  }
+  for (int i = temp.size() - 1; i >= 0; i--) {
+    std::cout << temp[i];
+  }
+}
+
+template <typename T> inline void printQueue(std::queue<T> q) {
+  while (!q.empty()) {
+    std::cout << q.front();
+    q.pop();
+  }
+}
+
+// Gives every grammar symbol name a dense id. Terminals and nonterminals
+// share the numbering, and each symbol also has an index among those of its
+// own kind for table rows and columns. Epsilon and the end marker "#" are
+// always the first two terminals.
+class SymbolTable {
+public:
+  static constexpr Symbol EPSILON = 0, END = 1;
+
+  SymbolTable() {
+    by_char.fill(NO_SYMBOL);
+    intern(Epsilon, false);
+    intern("#", false);
+  }
+
+  Symbol intern(const std::string &name, bool nonterminal) {
+    auto it = ids.find(name);
+    if (it != ids.end()) {
+      if (isNonterminal(it->second) != nonterminal)
+        throw std::runtime_error("Symbol is both terminal and nonterminal: " +
+                                 name);
+      return it->second;
+    }
+    Symbol id = names.size();
+    auto &kind = nonterminal ? nonterminal_ids : terminal_ids;
+    names.push_back(name);
+    kinds.push_back(nonterminal);
+    indices.push_back(kind.size());
+    kind.push_back(id);
+    ids[name] = id;
+    if (name.size() == 1)
+      by_char[static_cast<unsigned char>(name[0])] = id;
+    return id;
+  }
+
+  // One-character names, which is every symbol of the PL/0 grammar, are
+  // looked up without hashing.
+  Symbol find(const std::string &name) const {
+    if (name.size() == 1)
+      return by_char[static_cast<unsigned char>(name[0])];
+    auto it = ids.find(name);
+    return it == ids.end() ? NO_SYMBOL : it->second;
+  }
+
+  Symbol findTerminal(const std::string &name) const {
+    Symbol s = find(name);
+    return s != NO_SYMBOL && isNonterminal(s) ? NO_SYMBOL : s;
+  }
+
+  void reserve(size_t symbols) {
+    names.reserve(symbols);
+    indices.reserve(symbols);
+    ids.reserve(symbols);
+  }
+
+  const std::string &name(Symbol s) const { return names[s]; }
+  bool isNonterminal(Symbol s) const { return kinds[s]; }
+  int index(Symbol s) const { return indices[s]; }
+  size_t size() const { return names.size(); }
+  const std::vector<Symbol> &nonterminals() const { return nonterminal_ids; }
+  const std::vector<Symbol> &terminals() const { return terminal_ids; }
+
+private:
+  std::vector<std::string> names;
+  std::vector<bool> kinds;
+  std::vector<int> indices;
+  std::vector<Symbol> nonterminal_ids, terminal_ids;
+  std::unordered_map<std::string, Symbol> ids;
+  std::array<Symbol, 256> by_char;
+};
+
+inline void printStack(std::stack<Symbol> t, const SymbolTable &symbols) {
+  std::vector<Symbol> temp;
+  while (!t.empty()) {
+    temp.push_back(t.top());
+    t.pop();
+  }
+  for (int i = temp.size() - 1; i >= 0; i--) {
+    std::cout << symbols.name(temp[i]);
+  }
+}
+
+// Consecutive symbols of a production's right-hand side.
+struct SymbolSpan {
+  const Symbol *first, *last;
+  const Symbol *begin() const { return first; }
+  const Symbol *end() const { return last; }
+  size_t size() const { return last - first; }
+  bool empty() const { return first == last; }
+  Symbol operator[](size_t i) const { return first[i]; }
+};
+
+// A production with its right-hand side stored as [begin, end) of the
+// grammar's symbol array; epsilon is the empty range. alternative is its
+// position among the productions of lhs.
+struct Production {
+  Symbol lhs;
+  int alternative;
+  uint32_t begin, end;
+};
+
+class Nonterminal {
+public:
+  std::string name;
+  // As written, and split into symbol names.
+  std::vector<std::string> productions;
+  std::vector<std::vector<std::string>> production_symbols;
+  // Set by Grammar: the interned name, the ids of the productions and
+  // whether the nonterminal derives the empty string.
+  Symbol symbol;
+  std::vector<int> rules;
+  bool generallyEmpty;
+  Nonterminal() : name(Invalid), symbol(NO_SYMBOL), generallyEmpty(false) {}
+  Nonterminal(const std::string &name)
+      : name(name), symbol(NO_SYMBOL), generallyEmpty(false) {}
+  void addProduction(const std::string &symbols) {
+    productions.push_back(symbols);
+    production_symbols.push_back(splitProduction(symbols));
+  }
+  // Names may be any length here.
+  void addProduction(const std::vector<std::string> &symbols) {
+    productions.push_back(productionText(symbols));
+    production_symbols.push_back(symbols);
+  }
+
+  friend std::ostream &operator<<(std::ostream &os, const Nonterminal &self) {
+    for (auto var : self.productions) {
+      os << "      " << self.name << " --> " << (ToEpsilon(var)) << std::endl;
+    }
+    return os;
+  }
+};
+
+class Terminal {
+public:
+  std::string name;
+  Terminal() : name(Invalid) {}
+  Terminal(const std::string &name) : name(name) {}
+
+  friend std::ostream &operator<<(std::ostream &os, const Terminal &self) {
+    os << self.name;
+    return os;
+  }
+};
+
+// Symbols and productions are interned on construction, so the analyses
+// below work on integer ids; the name-based getters convert at the edges.
+class Grammar {
+public:
+  std::string start_symbol;
+  Grammar(const std::string &start_symbol,
+          std::vector<Nonterminal *> in_nonterminals,
+          std::vector<Terminal *> in_terminals)
+      : start_symbol(start_symbol) {
+    for (Nonterminal *var : in_nonterminals) {
+      nonterminals.push_back(*var);
+    }
+    for (Terminal *var : in_terminals) {
+      terminals[var->name] = var;
+    }
+    intern();
+  };
+
+  Grammar(const std::string &start_symbol,
+          std::vector<Nonterminal *> in_nonterminals,
+          std::unordered_map<std::string, Terminal *> in_terminals)
+      : start_symbol(start_symbol) {
+    for (Nonterminal *var : in_nonterminals) {
+      nonterminals.push_back(*var);
+    }
+    terminals = in_terminals;
+    intern();
+  };
+
+  friend std::ostream &operator<<(std::ostream &os, const Grammar &self) {
+    os << "G[" << self.start_symbol << "]: \n";
+    for (const auto &node : self.nonterminals) {
+      os << node;
+    }
+    return os;
+  }
+
+  bool hasNonterminal(const std::string &name) {
+    Symbol s = symbols.find(name);
+    return s != NO_SYMBOL && symbols.isNonterminal(s);
+  }
+
+  std::set<std::string> getTargetFirstSet(const std::string &name) {
+    return names(getFirstSet(getTargetNonterminal(name)->symbol));
+  }
+
+  std::set<std::string> getTargetFollowSet(const std::string &name) {
+    return names(getFollowSet(getTargetNonterminal(name)->symbol));
+  }
+
+  std::set<std::string> getTargetSelectSet(const std::string &name,
+                                           const std::string &production) {
+    auto node = getTargetNonterminal(name);
+    for (size_t i = 0; i < node->productions.size(); i++) {
+      if (node->productions[i] == production)
+        return names(getSelectSet(node->rules[i]));
+    }
+    throw std::runtime_error("Unexpected production for Nonterminal " + name);
+  }
+
+  void getAllSelectSet() {
+    if (!selectDone)
+      computeSelect();
+  }
+
+  // Runs the set analyses on pool, a component of each dependency graph per
+  // task, or sequentially when pool is null. The sets come out the same
+  // either way. The pool is not owned and must outlive the analyses.
+  void setAnalysisPool(WorkStealingPool *pool) { this->pool = pool; }
+
+  friend void buildPredcitTable(Grammar &G, TableType &table) {
+    const SymbolTable &symbols = G.symbols;
+    table.assign(symbols.nonterminals().size(),
+                 std::vector<int>(symbols.terminals().size(), NO_RULE));
+    for (const auto &node : G.nonterminals)
+      G.fillPredictRow(node, table[symbols.index(node.symbol)]);
+  }
+
+  // Keeps one table up to date with the productions added and removed
+  // since its last call: new rows and columns are added and only the rows
+  // whose productions or SELECT sets changed are filled again. The first
+  // call, and the first after the symbols were renumbered, builds it.
+  friend void updatePredictTable(Grammar &G, TableType &table) {
+    if (G.all_rows_stale || !G.selectDone) {
+      buildPredcitTable(G, table);
+      G.stale_rows.clear();
+      G.all_rows_stale = false;
+      return;
+    }
+    const SymbolTable &symbols = G.symbols;
+    table.resize(symbols.nonterminals().size());
+    for (auto &row : table)
+      row.resize(symbols.terminals().size(), NO_RULE);
+    auto &stale = G.stale_rows;
+    std::sort(stale.begin(), stale.end());
+    stale.erase(std::unique(stale.begin(), stale.end()), stale.end());
+    for (int non : stale)
+      G.fillPredictRow(G.nonterminals[non], table[non]);
+    stale.clear();
+  }
+  std::unordered_map<std::string, Terminal *> getTerminal() {
+    return terminals;
+  }
+
+  const SymbolTable &getSymbols() const { return symbols; }
+  Symbol getStart() const { return start; }
+  size_t productionCount() const { return rules.size(); }
+  const Production &getProduction(int rule) const { return rules[rule]; }
+  SymbolSpan getRhs(int rule) const {
+    const Symbol *base = rule_symbols.data();
+    return {base + rules[rule].begin, base + rules[rule].end};
+  }
+  // The production as written, e.g. for traces.
+  const std::string &getProductionText(int rule) const {
+    const Production &p = rules[rule];
+    return nonterminals[symbols.index(p.lhs)].productions[p.alternative];
+  }
+  const std::vector<int> &getRules(Symbol non) const {
+    return nonterminals[symbols.index(non)].rules;
+  }
+
+  // FIRST includes epsilon for nullable nonterminals; FOLLOW and SELECT
+  // never do. Each kind is computed for the whole grammar on first use and
+  // kept up to date by addProduction() and removeProduction().
+  const TerminalSet &getFirstSet(Symbol non) {
+    if (!firstDone)
+      computeFirst();
+    return firstCache[symbols.index(non)];
+  }
+  const TerminalSet &getFollowSet(Symbol non) {
+    if (!followDone)
+      computeFollow();
+    return followCache[symbols.index(non)];
+  }
+  const TerminalSet &getSelectSet(int rule) {
+    if (!selectDone)
+      computeSelect();
+    return selectCache[rule];
+  }
+
+  // Edits a production in place. The analyses done so far are kept: only
+  // the nullable, FIRST, FOLLOW and SELECT sets the change can reach are
+  // worked out again, and the predict table rows they fill are left for
+  // updatePredictTable(). A name the grammar does not know yet becomes a
+  // terminal. Giving a terminal a production makes it a nonterminal, which
+  // renumbers the symbols and starts the analyses over. Returns the id of
+  // the new production.
+  int addProduction(const std::string &lhs,
+                    const std::vector<std::string> &names) {
+    Symbol a = symbols.find(lhs);
+    if (a != NO_SYMBOL && !symbols.isNonterminal(a)) {
+      SymbolGrammarInputType named = namedProductions();
+      named.push_back({lhs, {names}});
+      setProductions(named);
+      return rules.size() - 1;
+    }
+    ensureOccurrences();
+    size_t terminal_count = symbols.terminals().size();
+    if (a == NO_SYMBOL) {
+      a = symbols.intern(lhs, true);
+      nonterminals.emplace_back(lhs);
+      nonterminals.back().symbol = a;
+      nullable.push_back(false);
+      occurrences.emplace_back();
+      if (firstDone)
+        firstCache.emplace_back(terminal_count);
+      if (followDone)
+        followCache.emplace_back(terminal_count);
+    }
+    int non = symbols.index(a), rule = rules.size();
+    Nonterminal &node = nonterminals[non];
+    Production p{a, static_cast<int>(node.rules.size()),
+                 static_cast<uint32_t>(rule_symbols.size()), 0};
+    for (const auto &name : names) {
+      Symbol s = symbols.find(name);
+      if (s == NO_SYMBOL)
+        s = symbols.intern(name, false);
+      rule_symbols.push_back(s);
+    }
+    p.end = rule_symbols.size();
+    rules.push_back(p);
+    node.rules.push_back(rule);
+    node.productions.push_back(productionText(names));
+    node.production_symbols.push_back(names);
+    if (selectDone)
+      selectCache.emplace_back(terminal_count);
+    if (symbols.terminals().size() != terminal_count) {
+      for (auto *cache : {&firstCache, &followCache, &selectCache}) {
+        for (auto &set : *cache)
+          set.resize(symbols.terminals().size());
+      }
+    }
+    addOccurrences(rule);
+    reanalyse(non, rhsNonterminals(rule), rule);
+    return rule;
+  }
+
+  // The production in the one-character notation.
+  int addProduction(const std::string &lhs, const std::string &production) {
+    return addProduction(lhs, splitProduction(production));
+  }
+
+  // Removes a production, analysing again as addProduction() does. The
+  // last production takes over its id. The lhs stays a nonterminal even
+  // with no productions left.
+  void removeProduction(int rule) {
+    if (rule < 0 || static_cast<size_t>(rule) >= rules.size())
+      throw std::runtime_error("Unexpected production " +
+                               std::to_string(rule));
+    ensureOccurrences();
+    Production p = rules[rule];
+    int non = symbols.index(p.lhs);
+    Nonterminal &node = nonterminals[non];
+    std::vector<int> rhs = rhsNonterminals(rule);
+    for (int b : rhs) {
+      auto &uses = occurrences[b];
+      uses.erase(std::find(uses.begin(), uses.end(), rule));
+    }
+    node.productions.erase(node.productions.begin() + p.alternative);
+    node.production_symbols.erase(node.production_symbols.begin() +
+                                  p.alternative);
+    node.rules.erase(node.rules.begin() + p.alternative);
+    for (size_t i = p.alternative; i < node.rules.size(); i++)
+      rules[node.rules[i]].alternative--;
+    stale_rows.push_back(non);
+    int last = rules.size() - 1;
+    if (rule != last) {
+      rules[rule] = rules[last];
+      int owner = symbols.index(rules[rule].lhs);
+      nonterminals[owner].rules[rules[rule].alternative] = rule;
+      for (int b : rhsNonterminals(rule)) {
+        auto &uses = occurrences[b];
+        *std::find(uses.begin(), uses.end(), last) = rule;
+      }
+      if (selectDone)
+        selectCache[rule] = std::move(selectCache[last]);
+      stale_rows.push_back(owner);
+    }
+    rules.pop_back();
+    if (selectDone)
+      selectCache.pop_back();
+    // The removed right-hand side stays in rule_symbols until most of it
+    // is such leftovers.
+    dead_symbols += p.end - p.begin;
+    if (dead_symbols > rule_symbols.size() / 2) {
+      std::vector<Symbol> compact;
+      compact.reserve(rule_symbols.size() - dead_symbols);
+      for (auto &production : rules) {
+        uint32_t begin = compact.size();
+        compact.insert(compact.end(), rule_symbols.begin() + production.begin,
+                       rule_symbols.begin() + production.end);
+        production.begin = begin;
+        production.end = compact.size();
+      }
+      rule_symbols.swap(compact);
+      dead_symbols = 0;
+    }
+    reanalyse(non, rhs, NO_RULE);
+  }
+
+  // The transformations below rewrite the productions by name and intern
+  // the result again, so the analyses start over afterwards. A nonterminal
+  // they add is named after the one it came from with a ' added.
+
+  // Removes left recursion, immediate or through other nonterminals. Within
+  // each cycle of nonterminals whose productions start with one another,
+  // earlier members are substituted into later ones, which leaves only
+  // A -> A alpha | beta; that becomes A -> beta A', A' -> alpha A' | epsilon.
+  // Recursion hidden behind a nullable first symbol is left alone.
+  void eliminateLeftRecursion() {
+    SymbolGrammarInputType named = namedProductions();
+    eliminateLeftRecursion(named);
+    setProductions(named);
+  }
+
+  // Left factors: alternatives of a nonterminal that start alike become
+  // A -> prefix A' with their different tails under A', until no two
+  // alternatives of any nonterminal share a first symbol.
+  void removeCommonPrefix() {
+    SymbolGrammarInputType named = namedProductions();
+    removeCommonPrefix(named);
+    setProductions(named);
+  }
+
+  // Drops nonterminals that derive no string of terminals, then those the
+  // start symbol cannot reach, together with every production using them.
+  void removeUselessSymbols() {
+    SymbolGrammarInputType named = namedProductions();
+    removeUselessSymbols(named);
+    setProductions(named);
+  }
+
+  // Replaces each unit production A -> B by B's other productions,
+  // following chains of them, so that A -> B -> beta is one expansion.
+  // A keeps its unit productions when that would give it one starting with
+  // A. Nonterminals only reached that way are left unreachable.
+  void collapseUnitProductions() {
+    SymbolGrammarInputType named = namedProductions();
+    collapseUnitProductions(named);
+    setProductions(named);
+  }
+
+  // All of the above, in an order where none undoes another: unit
+  // productions are collapsed before factoring since inlining can bring
+  // alike alternatives together, and what collapsing strands is pruned last.
+  void optimize() {
+    SymbolGrammarInputType named = namedProductions();
+    removeUselessSymbols(named);
+    eliminateLeftRecursion(named);
+    collapseUnitProductions(named);
+    removeCommonPrefix(named);
+    removeUselessSymbols(named);
+    setProductions(named);
+  }
+
+  std::vector<std::string> getNonterminalNames() {
+    std::vector<std::string> names;
+    for (const auto &node : nonterminals)
+      names.push_back(node.name);
+    return names;
+  }
+
+  Nonterminal *getTargetNonterminal(const std::string &name) {
+    Symbol s = symbols.find(name);
+    if (s == NO_SYMBOL || !symbols.isNonterminal(s))
+      throw std::runtime_error("Unexpected key for nonterminals: " + name);
+    return &nonterminals[symbols.index(s)];
+  };
+
+  void printSets(const std::string &target) {
+    std::cout << "=============================\n";
+    std::cout << target << " set:\n"
+              << "============================\n";
+    _printSets(getSet(target));
+  }
+
+  SetType getSet(const std::string &target) {
+    SetType sets;
+    if (target == "first" || target == "follow") {
+      bool done = target == "first" ? firstDone : followDone;
+      auto &cache = target == "first" ? firstCache : followCache;
+      for (const auto &node : nonterminals) {
+        if (done)
+          sets[node.name] = names(cache[symbols.index(node.symbol)]);
+      }
+    } else if (target == "select") {
+      for (size_t rule = 0; rule < rules.size(); rule++) {
+        if (selectDone)
+          sets[symbols.name(rules[rule].lhs) + " --> " +
+               getProductionText(rule)] = names(selectCache[rule]);
+      }
+    } else {
+      throw std::runtime_error("Unexpected print mode " + target);
+    }
+    return sets;
+  }
+
+private:
+  // TableImage restores a grammar and its analyses without recomputing them.
+  friend class TableImage;
+  Grammar() : start(NO_SYMBOL) {}
+
+  void _printSets(std::unordered_map<std::string, std::set<std::string>> inp) {
+    for (auto it = inp.begin(); it != inp.end(); it++) {
+      _printSet(it->first, it->second);
+    }
+  }
+  void _printSet(const std::string &name, const std::set<std::string> &s) {
+    std::cout << name << (name.size() == 2 ? "" : " ") << ": { ";
+    for (const auto &element : s) {
+      std::cout << ToEpsilon(element) << " ";
+    }
+    std::cout << "}\n";
+  }
+
+  SymbolGrammarInputType namedProductions() const {
+    SymbolGrammarInputType named;
+    for (const auto &node : nonterminals)
+      named.push_back({node.name, node.production_symbols});
+    return named;
+  }
+
+  void setProductions(const SymbolGrammarInputType &named) {
+    std::vector<Nonterminal> rebuilt;
+    for (const auto &entry : named) {
+      Nonterminal node(entry.first);
+      for (const auto &symbols : entry.second) {
+        node.productions.push_back(productionText(symbols));
+        node.production_symbols.push_back(symbols);
+      }
+      rebuilt.push_back(node);
+    }
+    nonterminals = rebuilt;
+    intern();
+  }
+
+  // A name for a nonterminal derived from base that no symbol has yet.
+  static std::string freshName(const SymbolGrammarInputType &named,
+                               const std::string &base) {
+    std::set<std::string> taken;
+    for (const auto &entry : named) {
+      taken.insert(entry.first);
+      for (const auto &symbols : entry.second)
+        taken.insert(symbols.begin(), symbols.end());
+    }
+    std::string name = base + "'";
+    while (taken.count(name))
+      name += "'";
+    return name;
+  }
+
+  static std::unordered_map<std::string, int>
+  positions(const SymbolGrammarInputType &named) {
+    std::unordered_map<std::string, int> at;
+    for (size_t i = 0; i < named.size(); i++)
+      at[named[i].first] = i;
+    return at;
+  }
+
+  void eliminateLeftRecursion(SymbolGrammarInputType &named) const {
+    auto at = positions(named);
+    // An edge from A to B when a production of A starts with B.
+    DependencyGraph graph(named.size());
+    for (size_t i = 0; i < named.size(); i++) {
+      for (const auto &symbols : named[i].second) {
+        if (!symbols.empty() && at.count(symbols[0]))
+          graph.addEdge(i, at[symbols[0]]);
+      }
+    }
+    Components components = graph.components();
+    // Each A' is appended, then moved right after its A.
+    const size_t original = named.size();
+    std::vector<size_t> owner;
+    for (size_t c = 0; c < components.size(); c++) {
+      std::vector<int> cycle(components[c].begin(), components[c].end());
+      std::sort(cycle.begin(), cycle.end());
+      for (size_t i = 0; i < cycle.size(); i++) {
+        for (size_t j = 0; j < i; j++) {
+          std::vector<std::vector<std::string>> substituted;
+          for (const auto &symbols : named[cycle[i]].second) {
+            if (symbols.empty() || symbols[0] != named[cycle[j]].first) {
+              substituted.push_back(symbols);
+              continue;
+            }
+            for (const auto &prefix : named[cycle[j]].second) {
+              substituted.push_back(prefix);
+              substituted.back().insert(substituted.back().end(),
+                                        symbols.begin() + 1, symbols.end());
+            }
+          }
+          named[cycle[i]].second = substituted;
+        }
+        const std::string name = named[cycle[i]].first;
+        std::vector<std::vector<std::string>> recursive, others;
+        bool left = false;
+        for (const auto &symbols : named[cycle[i]].second) {
+          if (symbols.empty() || symbols[0] != name) {
+            others.push_back(symbols);
+            continue;
+          }
+          left = true;
+          // A -> A derives nothing new and is dropped.
+          if (symbols.size() > 1)
+            recursive.emplace_back(symbols.begin() + 1, symbols.end());
+        }
+        if (!left)
+          continue;
+        if (!recursive.empty()) {
+          std::string tail = freshName(named, name);
+          for (auto &symbols : others)
+            symbols.push_back(tail);
+          for (auto &symbols : recursive)
+            symbols.push_back(tail);
+          recursive.emplace_back();
+          named.push_back({tail, recursive});
+          owner.push_back(cycle[i]);
+        }
+        named[cycle[i]].second = others;
+      }
+    }
+    SymbolGrammarInputType ordered;
+    for (size_t i = 0; i < original; i++) {
+      ordered.push_back(named[i]);
+      for (size_t k = 0; k < owner.size(); k++) {
+        if (owner[k] == i)
+          ordered.push_back(named[original + k]);
+      }
+    }
+    named = ordered;
+  }
+
+  void removeCommonPrefix(SymbolGrammarInputType &named) const {
+    for (size_t i = 0; i < named.size(); i++) {
+      for (;;) {
+        auto &alternatives = named[i].second;
+        std::vector<std::vector<std::string>> unique;
+        for (const auto &symbols : alternatives) {
+          if (std::find(unique.begin(), unique.end(), symbols) == unique.end())
+            unique.push_back(symbols);
+        }
+        alternatives = unique;
+        // The first alternative whose first symbol another one shares.
+        size_t first = 0, shared = 0;
+        for (; first < alternatives.size(); first++) {
+          if (alternatives[first].empty())
+            continue;
+          shared = std::count_if(
+              alternatives.begin() + first, alternatives.end(),
+              [&](const std::vector<std::string> &symbols) {
+                return !symbols.empty() &&
+                       symbols[0] == alternatives[first][0];
+              });
+          if (shared > 1)
+            break;
+        }
+        if (first == alternatives.size())
+          break;
+        std::vector<std::string> prefix = alternatives[first];
+        std::vector<std::vector<std::string>> rest, tails;
+        for (size_t a = 0; a < alternatives.size(); a++) {
+          const auto &symbols = alternatives[a];
+          if (a < first || symbols.empty() || symbols[0] != prefix[0]) {
+            rest.push_back(symbols);
+            continue;
+          }
+          size_t n = 0;
+          while (n < prefix.size() && n < symbols.size() &&
+                 prefix[n] == symbols[n])
+            n++;
+          prefix.resize(n);
+          tails.push_back(symbols);
+        }
+        std::string tail = freshName(named, named[i].first);
+        for (auto &symbols : tails)
+          symbols.erase(symbols.begin(), symbols.begin() + prefix.size());
+        prefix.push_back(tail);
+        rest.insert(rest.begin() + first, prefix);
+        named[i].second = rest;
+        named.insert(named.begin() + i + 1, {tail, tails});
+      }
+    }
+  }
+
+  void removeUselessSymbols(SymbolGrammarInputType &named) const {
+    auto at = positions(named);
+    std::vector<char> productive(named.size(), false);
+    auto derives = [&](const std::vector<std::string> &symbols) {
+      for (const auto &name : symbols) {
+        auto it = at.find(name);
+        if (it != at.end() && !productive[it->second])
+          return false;
+      }
+      return true;
+    };
+    for (bool changed = true; changed;) {
+      changed = false;
+      for (size_t i = 0; i < named.size(); i++) {
+        if (productive[i])
+          continue;
+        for (const auto &symbols : named[i].second) {
+          if (derives(symbols)) {
+            productive[i] = changed = true;
+            break;
+          }
+        }
+      }
+    }
+    auto start = at.find(start_symbol);
+    if (start == at.end() || !productive[start->second])
+      throw std::runtime_error("Start symbol derives no sentence: " +
+                               start_symbol);
+    std::vector<char> reachable(named.size(), false);
+    std::vector<int> work{start->second};
+    reachable[start->second] = true;
+    while (!work.empty()) {
+      int i = work.back();
+      work.pop_back();
+      auto &alternatives = named[i].second;
+      alternatives.erase(std::remove_if(alternatives.begin(),
+                                        alternatives.end(),
+                                        [&](const auto &symbols) {
+                                          return !derives(symbols);
+                                        }),
+                         alternatives.end());
+      for (const auto &symbols : alternatives) {
+        for (const auto &name : symbols) {
+          auto it = at.find(name);
+          if (it != at.end() && !reachable[it->second]) {
+            reachable[it->second] = true;
+            work.push_back(it->second);
+          }
+        }
+      }
+    }
+    SymbolGrammarInputType kept;
+    for (size_t i = 0; i < named.size(); i++) {
+      if (reachable[i])
+        kept.push_back(named[i]);
+    }
+    named = kept;
+  }
+
+  void collapseUnitProductions(SymbolGrammarInputType &named) const {
+    auto at = positions(named);
+    auto isUnit = [&](const std::vector<std::string> &symbols) {
+      return symbols.size() == 1 && at.count(symbols[0]);
+    };
+    SymbolGrammarInputType collapsed = named;
+    for (size_t i = 0; i < named.size(); i++) {
+      // The nonterminals A reaches through unit productions, A first.
+      std::vector<int> chain{static_cast<int>(i)};
+      for (size_t k = 0; k < chain.size(); k++) {
+        for (const auto &symbols : named[chain[k]].second) {
+          if (isUnit(symbols) &&
+              std::find(chain.begin(), chain.end(), at[symbols[0]]) ==
+                  chain.end())
+            chain.push_back(at[symbols[0]]);
+        }
+      }
+      std::vector<std::vector<std::string>> alternatives;
+      for (int k : chain) {
+        for (const auto &symbols : named[k].second) {
+          if (!isUnit(symbols) &&
+              std::find(alternatives.begin(), alternatives.end(), symbols) ==
+                  alternatives.end())
+            alternatives.push_back(symbols);
+        }
+      }
+      bool recursive = false;
+      for (const auto &symbols : alternatives)
+        recursive |= !symbols.empty() && symbols[0] == named[i].first;
+      if (!recursive)
+        collapsed[i].second = alternatives;
+    }
+    named = collapsed;
+  }
+
+  std::set<std::string> names(const TerminalSet &set) const {
+    std::set<std::string> result;
+    for (int t : set)
+      result.insert(symbols.name(symbols.terminals()[t]));
+    return result;
+  }
+
+  bool isNullable(Symbol s) const {
+    return symbols.isNonterminal(s) && nullable[symbols.index(s)];
+  }
+
+  // A is nullable when some production of A has only nullable symbols.
+  // Each production counts its symbols not yet known to be nullable, and
+  // each nonterminal lists where it occurs; marking a nonterminal nullable
+  // counts down its occurrences, and a production reaching zero marks its
+  // lhs. Every occurrence is visited at most once, so this is linear in the
+  // size of the grammar. A production with a terminal never reaches zero.
+  void computeNullable() {
+    nullable.assign(nonterminals.size(), false);
+    std::vector<uint32_t> remaining(rules.size());
+    // occurrences of nonterminal i are uses[starts[i]] up to starts[i + 1].
+    std::vector<uint32_t> starts(nonterminals.size() + 1, 0);
+    std::vector<int> uses, work;
+    for (size_t rule = 0; rule < rules.size(); rule++) {
+      SymbolSpan rhs = getRhs(rule);
+      remaining[rule] = rhs.size();
+      if (allNonterminals(rule)) {
+        for (Symbol s : rhs)
+          starts[symbols.index(s) + 1]++;
+      }
+    }
+    for (size_t i = 0; i < nonterminals.size(); i++)
+      starts[i + 1] += starts[i];
+    uses.resize(starts.back());
+    std::vector<uint32_t> fill(starts.begin(), starts.end() - 1);
+    for (size_t rule = 0; rule < rules.size(); rule++) {
+      if (!allNonterminals(rule))
+        continue;
+      for (Symbol s : getRhs(rule))
+        uses[fill[symbols.index(s)]++] = rule;
+      if (remaining[rule] == 0)
+        markNullable(symbols.index(rules[rule].lhs), work);
+    }
+    while (!work.empty()) {
+      int non = work.back();
+      work.pop_back();
+      for (uint32_t i = starts[non]; i < starts[non + 1]; i++) {
+        int rule = uses[i];
+        if (--remaining[rule] == 0)
+          markNullable(symbols.index(rules[rule].lhs), work);
+      }
+    }
+    for (size_t i = 0; i < nonterminals.size(); i++)
+      nonterminals[i].generallyEmpty = nullable[i];
+  }
+
+  void markNullable(int non, std::vector<int> &work) {
+    if (!nullable[non]) {
+      nullable[non] = true;
+      work.push_back(non);
+    }
+  }
+
+  bool allNonterminals(int rule) const {
+    for (Symbol s : getRhs(rule)) {
+      if (!symbols.isNonterminal(s))
+        return false;
+    }
+    return true;
+  }
+
+  // Closes sets under the graph's edges, so each set ends up with the sets
+  // of every node that reaches it. A component is solved once the
+  // components feeding it are final: it pulls in their sets and its own
+  // seeds, and every member of a cycle gets that one union. A component
+  // only writes its own sets, so components may be solved concurrently.
+  void propagate(std::vector<TerminalSet> &sets,
+                 const DependencyGraph &graph) {
+    Components components = graph.components();
+    forEachComponent(graph, components, pool, [&](int c) {
+      NodeSpan component = components[c];
+      TerminalSet &head = sets[component[0]];
+      for (int to : component) {
+        if (to != component[0])
+          head.merge(sets[to]);
+        for (int from : graph.predecessors(to)) {
+          if (components.of[from] != c)
+            head.merge(sets[from]);
+        }
+      }
+      for (size_t i = 1; i < component.size(); i++)
+        sets[component[i]] = head;
+    });
+  }
+
+  // FIRST(A) takes the terminal, or FIRST of each nonterminal, that can
+  // open a production of A.
+  void computeFirst() {
+    size_t terminals = symbols.terminals().size();
+    firstCache.assign(nonterminals.size(), TerminalSet(terminals));
+    DependencyGraph graph(nonterminals.size());
+    for (size_t rule = 0; rule < rules.size(); rule++) {
+      int lhs = symbols.index(rules[rule].lhs);
+      for (Symbol s : getRhs(rule)) {
+        if (!symbols.isNonterminal(s)) {
+          firstCache[lhs].insert(symbols.index(s));
+          break;
+        }
+        if (symbols.index(s) != lhs)
+          graph.addEdge(symbols.index(s), lhs);
+        if (!nullable[symbols.index(s)])
+          break;
+      }
+    }
+    propagate(firstCache, graph);
+    int epsilon = symbols.index(SymbolTable::EPSILON);
+    for (size_t i = 0; i < nonterminals.size(); i++) {
+      if (nullable[i])
+        firstCache[i].insert(epsilon);
+    }
+    firstDone = true;
+  }
+
+  // FOLLOW(B) takes FIRST of whatever follows B in a production, and
+  // FOLLOW(A) when that rest can vanish.
+  void computeFollow() {
+    if (!firstDone)
+      computeFirst();
+    size_t terminals = symbols.terminals().size();
+    int epsilon = symbols.index(SymbolTable::EPSILON);
+    followCache.assign(nonterminals.size(), TerminalSet(terminals));
+    followCache[symbols.index(start)].insert(symbols.index(SymbolTable::END));
+    DependencyGraph graph(nonterminals.size());
+    for (size_t rule = 0; rule < rules.size(); rule++) {
+      int lhs = symbols.index(rules[rule].lhs);
+      SymbolSpan rhs = getRhs(rule);
+      // FIRST of the symbols after position i, built right to left.
+      TerminalSet rest(terminals);
+      bool rest_nullable = true;
+      for (size_t i = rhs.size(); i-- > 0;) {
+        Symbol s = rhs[i];
+        if (!symbols.isNonterminal(s)) {
+          rest = TerminalSet(terminals);
+          rest.insert(symbols.index(s));
+          rest_nullable = false;
+          continue;
+        }
+        int b = symbols.index(s);
+        followCache[b].merge(rest);
+        if (rest_nullable && b != lhs)
+          graph.addEdge(lhs, b);
+        if (!nullable[b]) {
+          rest = firstCache[b];
+          rest_nullable = false;
+        } else {
+          rest.merge(firstCache[b]);
+        }
+        rest.erase(epsilon);
+      }
+    }
+    propagate(followCache, graph);
+    followDone = true;
+  }
+
+  // SELECT of each production is independent of the others, so on a pool
+  // the productions of a large grammar are split into a few ranges per
+  // worker.
+  void computeSelect() {
+    if (!followDone)
+      computeFollow();
+    size_t terminals = symbols.terminals().size();
+    selectCache.assign(rules.size(), TerminalSet(terminals));
+    auto solve = [&](size_t begin, size_t end) {
+      for (size_t rule = begin; rule < end; rule++)
+        selectSet(rule, selectCache[rule]);
+    };
+    if (pool && pool->size() > 1 && rules.size() >= MIN_PARALLEL_COMPONENTS) {
+      size_t chunk = rules.size() / (4 * pool->size()) + 1;
+      for (size_t begin = 0; begin < rules.size(); begin += chunk) {
+        size_t end = std::min(begin + chunk, rules.size());
+        pool->submit([&solve, begin, end] { solve(begin, end); });
+      }
+      pool->wait();
+    } else {
+      solve(0, rules.size());
+    }
+    selectDone = true;
+  }
+
+  // Adds SELECT of rule, from the FIRST and FOLLOW sets, to selects.
+  void selectSet(int rule, TerminalSet &selects) const {
+    bool generallyToEmpty = true;
+    for (Symbol s : getRhs(rule)) {
+      if (!symbols.isNonterminal(s)) {
+        selects.insert(symbols.index(s));
+        generallyToEmpty = false;
+        break;
+      }
+      selects.merge(firstCache[symbols.index(s)]);
+      if (!nullable[symbols.index(s)]) {
+        generallyToEmpty = false;
+        break;
+      }
+    }
+    selects.erase(symbols.index(SymbolTable::EPSILON));
+    if (generallyToEmpty)
+      selects.merge(followCache[symbols.index(rules[rule].lhs)]);
+  }
+
+  void fillPredictRow(const Nonterminal &node, std::vector<int> &row) {
+    std::fill(row.begin(), row.end(), NO_RULE);
+    for (int rule : node.rules) {
+      for (int t : getSelectSet(rule)) {
+        int &entry = row[t];
+        if (entry != NO_RULE)
+          throw std::runtime_error("Not LL(1) Grammar");
+        entry = rule;
+      }
+    }
+  }
+
+  // The productions each nonterminal occurs in, once each, by nonterminal
+  // index. Built for the first edit and kept up to date after that.
+  void ensureOccurrences() {
+    if (occurrences.size() == nonterminals.size())
+      return;
+    occurrences.assign(nonterminals.size(), {});
+    for (size_t rule = 0; rule < rules.size(); rule++)
+      addOccurrences(rule);
+  }
+
+  // rule must be the highest id yet listed.
+  void addOccurrences(int rule) {
+    for (Symbol s : getRhs(rule)) {
+      if (!symbols.isNonterminal(s))
+        continue;
+      auto &uses = occurrences[symbols.index(s)];
+      if (uses.empty() || uses.back() != rule)
+        uses.push_back(rule);
+    }
+  }
+
+  // The nonterminals on the right of rule, by index, once each.
+  std::vector<int> rhsNonterminals(int rule) const {
+    std::vector<int> found;
+    for (Symbol s : getRhs(rule)) {
+      int b = symbols.index(s);
+      if (symbols.isNonterminal(s) &&
+          std::find(found.begin(), found.end(), b) == found.end())
+        found.push_back(b);
+    }
+    return found;
+  }
+
+  bool derivesEmpty(int rule) const {
+    for (Symbol s : getRhs(rule)) {
+      if (!isNullable(s))
+        return false;
+    }
+    return true;
+  }
+
+  // Brings the analyses up to date after a production of nonterminal non,
+  // with the nonterminals rhs on its right, was added as added or removed
+  // (added is NO_RULE). Each set is worked out again for the nonterminals
+  // a changed set feeds, the others are kept.
+  void reanalyse(int non, const std::vector<int> &rhs, int added) {
+    std::vector<int> emptied = updateNullable(non, added);
+    if (!selectDone)
+      all_rows_stale = true;
+    if (!firstDone)
+      return;
+    int epsilon = symbols.index(SymbolTable::EPSILON);
+    // FIRST(A) changes with A's productions and with the nullability of
+    // their symbols, and feeds every B whose production A can open.
+    std::vector<int> seeds{non};
+    for (int x : emptied) {
+      seeds.push_back(x);
+      for (int rule : occurrences[x])
+        seeds.push_back(symbols.index(rules[rule].lhs));
+    }
+    std::vector<int> opened = resolve(
+        firstCache, seeds,
+        [&](int y, auto &&visit) {
+          for (int rule : occurrences[y]) {
+            for (Symbol s : getRhs(rule)) {
+              if (s == nonterminals[y].symbol) {
+                visit(symbols.index(rules[rule].lhs));
+                break;
+              }
+              if (!isNullable(s))
+                break;
+            }
+          }
+        },
+        [&](int a, TerminalSet &set, auto &&input) {
+          for (int rule : nonterminals[a].rules) {
+            for (Symbol s : getRhs(rule)) {
+              if (!symbols.isNonterminal(s)) {
+                set.insert(symbols.index(s));
+                break;
+              }
+              input(symbols.index(s));
+              if (!nullable[symbols.index(s)])
+                break;
+            }
+          }
+          set.erase(epsilon);
+        },
+        [&](int a, TerminalSet &set) {
+          if (nullable[a])
+            set.insert(epsilon);
+        });
+    // A nonterminal whose nullability changed gained or lost epsilon, so it
+    // is among opened.
+    std::vector<int> followed;
+    if (followDone) {
+      // FOLLOW(B) changes with what comes after B and feeds the
+      // nonterminals that can end a production of B.
+      seeds = rhs;
+      for (int x : opened) {
+        for (int rule : occurrences[x]) {
+          SymbolSpan span = getRhs(rule);
+          size_t last = span.size();
+          while (span[--last] != nonterminals[x].symbol)
+            ;
+          for (size_t i = 0; i < last; i++) {
+            if (symbols.isNonterminal(span[i]))
+              seeds.push_back(symbols.index(span[i]));
+          }
+        }
+      }
+      followed = resolve(
+          followCache, seeds,
+          [&](int a, auto &&visit) {
+            for (int rule : nonterminals[a].rules) {
+              SymbolSpan span = getRhs(rule);
+              for (size_t i = span.size(); i-- > 0;) {
+                if (!symbols.isNonterminal(span[i]))
+                  break;
+                visit(symbols.index(span[i]));
+                if (!nullable[symbols.index(span[i])])
+                  break;
+              }
+            }
+          },
+          [&](int b, TerminalSet &set, auto &&input) {
+            if (nonterminals[b].symbol == start)
+              set.insert(symbols.index(SymbolTable::END));
+            for (int rule : occurrences[b]) {
+              SymbolSpan span = getRhs(rule);
+              for (size_t i = 0; i < span.size(); i++) {
+                if (span[i] != nonterminals[b].symbol)
+                  continue;
+                size_t j = i + 1;
+                for (; j < span.size(); j++) {
+                  if (!symbols.isNonterminal(span[j])) {
+                    set.insert(symbols.index(span[j]));
+                    break;
+                  }
+                  set.merge(firstCache[symbols.index(span[j])]);
+                  if (!nullable[symbols.index(span[j])])
+                    break;
+                }
+                if (j == span.size())
+                  input(symbols.index(rules[rule].lhs));
+              }
+            }
+            set.erase(epsilon);
+          },
+          [](int, TerminalSet &) {});
+    }
+    if (!selectDone)
+      return;
+    std::vector<int> changed;
+    if (added != NO_RULE)
+      changed.push_back(added);
+    for (int x : opened)
+      changed.insert(changed.end(), occurrences[x].begin(),
+                     occurrences[x].end());
+    for (int b : followed)
+      changed.insert(changed.end(), nonterminals[b].rules.begin(),
+                     nonterminals[b].rules.end());
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+    for (int rule : changed) {
+      TerminalSet selects(symbols.terminals().size());
+      selectSet(rule, selects);
+      if (selects == selectCache[rule])
+        continue;
+      selectCache[rule] = selects;
+      stale_rows.push_back(symbols.index(rules[rule].lhs));
+    }
+  }
+
+  // Nullability only grows when a production is added, spreading to the
+  // nonterminals it completes a production of. A removal can only empty
+  // nonterminals that were nullable through non: those are cleared and
+  // derived again. Returns the nonterminals whose nullability changed.
+  std::vector<int> updateNullable(int non, int added) {
+    std::vector<int> changed;
+    if (added != NO_RULE) {
+      if (nullable[non] || !derivesEmpty(added))
+        return changed;
+      markNullable(non, changed);
+      for (size_t k = 0; k < changed.size(); k++) {
+        for (int rule : occurrences[changed[k]]) {
+          if (derivesEmpty(rule))
+            markNullable(symbols.index(rules[rule].lhs), changed);
+        }
+      }
+    } else {
+      if (!nullable[non])
+        return changed;
+      std::vector<int> region{non};
+      nullable[non] = false;
+      for (size_t k = 0; k < region.size(); k++) {
+        for (int rule : occurrences[region[k]]) {
+          int a = symbols.index(rules[rule].lhs);
+          if (nullable[a] && allNonterminals(rule)) {
+            nullable[a] = false;
+            region.push_back(a);
+          }
+        }
+      }
+      for (bool grew = true; grew;) {
+        grew = false;
+        for (int a : region) {
+          for (int rule : nonterminals[a].rules) {
+            if (!nullable[a] && derivesEmpty(rule))
+              nullable[a] = grew = true;
+          }
+        }
+      }
+      for (int a : region) {
+        if (!nullable[a])
+          changed.push_back(a);
+      }
+    }
+    for (int a : changed)
+      nonterminals[a].generallyEmpty = nullable[a];
+    return changed;
+  }
+
+  // Works sets out again for the nonterminals reachable from seeds along
+  // feeds(x, visit), which calls visit for each nonterminal x's set flows
+  // into; the sets of all others stay as they are. base(x, set, input)
+  // gives x's own part and calls input(y) for each y whose whole set x
+  // takes, and finish(x, set) runs before the result is stored. Returns the
+  // nonterminals whose set changed.
+  template <typename Feeds, typename Base, typename Finish>
+  std::vector<int> resolve(std::vector<TerminalSet> &sets,
+                           const std::vector<int> &seeds, Feeds feeds,
+                           Base base, Finish finish) {
+    std::vector<int> region, local(nonterminals.size(), -1);
+    auto visit = [&](int x) {
+      if (local[x] < 0) {
+        local[x] = region.size();
+        region.push_back(x);
+      }
+    };
+    for (int x : seeds)
+      visit(x);
+    for (size_t k = 0; k < region.size(); k++)
+      feeds(region[k], visit);
+    size_t terminals = symbols.terminals().size();
+    std::vector<TerminalSet> solved(region.size(), TerminalSet(terminals));
+    DependencyGraph graph(region.size());
+    for (size_t k = 0; k < region.size(); k++) {
+      base(region[k], solved[k], [&](int y) {
+        if (local[y] < 0)
+          solved[k].merge(sets[y]);
+        else if (local[y] != static_cast<int>(k))
+          graph.addEdge(local[y], k);
+      });
+    }
+    propagate(solved, graph);
+    std::vector<int> changed;
+    for (size_t k = 0; k < region.size(); k++) {
+      finish(region[k], solved[k]);
+      if (solved[k] == sets[region[k]])
+        continue;
+      sets[region[k]] = std::move(solved[k]);
+      changed.push_back(region[k]);
+    }
+    return changed;
+  }
+
+  // Assigns ids to every name, nonterminals first so that a name with
+  // productions is a nonterminal whatever it looks like, and lays the
+  // productions out in one array. Clears the analysis caches and works out
+  // which nonterminals are nullable.
+  void intern() {
+    symbols = SymbolTable();
+    rules.clear();
+    rule_symbols.clear();
+    for (auto &node : nonterminals)
+      node.symbol = symbols.intern(node.name, true);
+    start = symbols.find(start_symbol);
+    if (start == NO_SYMBOL || !symbols.isNonterminal(start))
+      throw std::runtime_error("Unexpected key for nonterminals: " +
+                               start_symbol);
+    for (auto &node : nonterminals) {
+      node.rules.clear();
+      for (size_t i = 0; i < node.production_symbols.size(); i++) {
+        Production p{node.symbol, static_cast<int>(i),
+                     static_cast<uint32_t>(rule_symbols.size()), 0};
+        for (const auto &name : node.production_symbols[i]) {
+          Symbol s = symbols.find(name);
+          if (s == NO_SYMBOL)
+            s = symbols.intern(name, false);
+          rule_symbols.push_back(s);
+        }
+        p.end = rule_symbols.size();
+        node.rules.push_back(rules.size());
+        rules.push_back(p);
+      }
+    }
+    firstDone = followDone = selectDone = false;
+    occurrences.clear();
+    stale_rows.clear();
+    all_rows_stale = true;
+    dead_symbols = 0;
+    computeNullable();
+  }
+
+  SymbolTable symbols;
+  Symbol start;
+  // Indexed by SymbolTable::index() of the nonterminal.
+  std::vector<Nonterminal> nonterminals;
+  std::unordered_map<std::string, Terminal *> terminals;
+  std::vector<Production> rules;
+  std::vector<Symbol> rule_symbols;
+  // nullable, first and follow by nonterminal index, select by production.
+  std::vector<char> nullable;
+  std::vector<TerminalSet> firstCache, followCache, selectCache;
+  bool firstDone = false, followDone = false, selectDone = false;
+  // Kept for the edits: see ensureOccurrences().
+  std::vector<std::vector<int>> occurrences;
+  // Predict table rows whose entries changed since the last
+  // updatePredictTable(), by nonterminal index, or all of them.
+  std::vector<int> stale_rows;
+  bool all_rows_stale = true;
+  // Symbols of removed productions still in rule_symbols.
+  size_t dead_symbols = 0;
+  WorkStealingPool *pool = nullptr;
+};
+
+inline Grammar *buildGrammar(const std::string &start_symbol,
+                             GrammarInputType &nonterminals) {
+  std::vector<Nonterminal *> targets;
+  std::unordered_map<std::string, Terminal *> terms;
+  for (auto it = nonterminals.begin(); it != nonterminals.end(); it++) {
+    if (!isNonterminal(it->first[0]))
+      throw std::runtime_error(
+          "Expect size of name to be 1 and is suppper letter.");
+    Nonterminal *temp = new Nonterminal(it->first);
+    for (std::string prod : it->second) {
+      for (auto s_it = prod.begin(); s_it != prod.end(); s_it++) {
+        char c = *s_it;
+        if (!isNonterminal(c))
+          terms[{c}] = new Terminal({c});
+      }
+      temp->addProduction(prod);
+    }
+    targets.push_back(temp);
+  }
+  auto g = new Grammar(start_symbol, targets, terms);
+  for (auto node : targets)
+    delete node;
+  return g;
+}
+
+// Builds a grammar whose productions are lists of symbol names, so names are
+// not limited to one character. A name is a nonterminal exactly when it has
+// productions; an empty list is epsilon.
+inline Grammar *buildGrammar(const std::string &start_symbol,
+                             const SymbolGrammarInputType &nonterminals) {
+  std::vector<Nonterminal *> targets;
+  std::unordered_map<std::string, Terminal *> terms;
+  std::set<std::string> defined;
+  for (const auto &entry : nonterminals) {
+    Nonterminal *temp = new Nonterminal(entry.first);
+    for (const auto &prod : entry.second)
+      temp->addProduction(prod);
+    targets.push_back(temp);
+    defined.insert(entry.first);
+  }
+  for (const auto &entry : nonterminals) {
+    for (const auto &prod : entry.second) {
+      for (const auto &name : prod) {
+        if (!defined.count(name) && !terms.count(name))
+          terms[name] = new Terminal(name);
+      }
+    }
+  }
+  auto g = new Grammar(start_symbol, targets, terms);
+  for (auto node : targets)
+    delete node;
+  return g;
+}
+
+#endif
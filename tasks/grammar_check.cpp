@@ -0,0 +1,207 @@
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "grammar.h"
+#include "source.h"
+
+// Checks the incremental grammar analyses against building afresh:
+//
+//   grammar_check [--grammars=N] [--edits=N] [--seed=N]
+//
+// Each random grammar goes through random addProduction() and
+// removeProduction() calls. After an edit its nullable, FIRST, FOLLOW and
+// SELECT sets, and the predict table updatePredictTable() keeps, must be
+// those buildGrammar() gives for the same productions. The first difference
+// is printed and the exit status is 1. Built with
+// -fsanitize=address,undefined it also checks the edits' memory use; run it
+// with ASAN_OPTIONS=detect_leaks=0, as no Grammar frees its Terminals.
+
+// A symbol of a grammar with nonterminals N0.. and terminals t0..; about a
+// third are terminals.
+std::string randomSymbol(std::mt19937_64 &rng, int nonterminals,
+                         int terminals) {
+  if (rng() % 3)
+    return "N" + std::to_string(rng() % nonterminals);
+  return "t" + std::to_string(rng() % terminals);
+}
+
+std::vector<std::string> randomRhs(std::mt19937_64 &rng, int nonterminals,
+                                   int terminals) {
+  std::vector<std::string> rhs;
+  for (int i = 0, n = rng() % 4; i < n; i++)
+    rhs.push_back(randomSymbol(rng, nonterminals, terminals));
+  return rhs;
+}
+
+SymbolGrammarInputType randomGrammar(std::mt19937_64 &rng, int nonterminals,
+                                     int terminals) {
+  SymbolGrammarInputType grammar;
+  for (int i = 0; i < nonterminals; i++) {
+    std::vector<std::vector<std::string>> alternatives;
+    for (int a = 0, n = 1 + rng() % 3; a < n; a++)
+      alternatives.push_back(randomRhs(rng, nonterminals, terminals));
+    grammar.push_back({"N" + std::to_string(i), alternatives});
+  }
+  return grammar;
+}
+
+// Adds a production that may bring in a new nonterminal or terminal, or
+// give a terminal productions, which renumbers the symbols.
+void addRandomProduction(Grammar &G, std::mt19937_64 &rng, int nonterminals,
+                         int terminals) {
+  std::string lhs = rng() % 20 ? "N" + std::to_string(rng() % nonterminals)
+                               : "t" + std::to_string(rng() % terminals);
+  std::vector<std::string> rhs;
+  for (int i = 0, n = rng() % 4; i < n; i++)
+    rhs.push_back(rng() % 5 ? randomSymbol(rng, nonterminals, terminals)
+                            : "u" + std::to_string(rng() % 64));
+  int rule = G.addProduction(lhs, rhs);
+  if (G.getSymbols().name(G.getProduction(rule).lhs) != lhs)
+    throw std::runtime_error("addProduction returned another production");
+}
+
+// G's productions built into a grammar from scratch.
+std::unique_ptr<Grammar> rebuild(Grammar &G) {
+  SymbolGrammarInputType named;
+  for (const auto &name : G.getNonterminalNames())
+    named.push_back({name, G.getTargetNonterminal(name)->production_symbols});
+  const SymbolTable &symbols = G.getSymbols();
+  return std::unique_ptr<Grammar>(
+      buildGrammar(symbols.name(G.getStart()), named));
+}
+
+// What the analyses found, by name, so grammars whose symbols are numbered
+// differently compare equal.
+std::string analysesText(Grammar &G) {
+  const SymbolTable &symbols = G.getSymbols();
+  auto names = [&](const TerminalSet &set) {
+    std::set<std::string> sorted;
+    for (int t : set)
+      sorted.insert(symbols.name(symbols.terminals()[t]));
+    std::string text;
+    for (const auto &name : sorted)
+      text += " " + name;
+    return text;
+  };
+  std::ostringstream os;
+  for (const auto &name : G.getNonterminalNames()) {
+    Nonterminal *node = G.getTargetNonterminal(name);
+    os << name << (node->generallyEmpty ? " nullable" : "") << "\n  FIRST"
+       << names(G.getFirstSet(node->symbol)) << "\n  FOLLOW"
+       << names(G.getFollowSet(node->symbol)) << "\n";
+    for (size_t a = 0; a < node->rules.size(); a++) {
+      int rule = node->rules[a];
+      const Production &p = G.getProduction(rule);
+      os << "  " << symbols.name(p.lhs) << " " << p.alternative << " ->";
+      if (p.alternative != int(a))
+        os << " (in slot " << a << ")";
+      for (Symbol s : G.getRhs(rule))
+        os << " " << symbols.name(s);
+      os << "\n    SELECT" << names(G.getSelectSet(rule)) << "\n";
+    }
+  }
+  return os.str();
+}
+
+// The filled cells of G's predict table by name, built afresh or brought up
+// to date, or "not LL(1)".
+std::string predictText(Grammar &G, TableType &table, bool update) {
+  try {
+    if (update)
+      updatePredictTable(G, table);
+    else
+      buildPredcitTable(G, table);
+  } catch (const std::runtime_error &) {
+    return "not LL(1)\n";
+  }
+  const SymbolTable &symbols = G.getSymbols();
+  std::set<std::string> cells;
+  for (size_t non = 0; non < table.size(); non++) {
+    for (size_t t = 0; t < table[non].size(); t++) {
+      int rule = table[non][t];
+      if (rule == NO_RULE)
+        continue;
+      std::string cell = symbols.name(symbols.nonterminals()[non]) + ", " +
+                         symbols.name(symbols.terminals()[t]) + ": ";
+      if (rule < 0 || size_t(rule) >= G.productionCount()) {
+        cell += "production " + std::to_string(rule);
+      } else {
+        const Production &p = G.getProduction(rule);
+        cell += symbols.name(p.lhs) + " " + std::to_string(p.alternative);
+      }
+      cells.insert(cell);
+    }
+  }
+  std::string text;
+  for (const auto &cell : cells)
+    text += cell + "\n";
+  return text;
+}
+
+int main(int argc, char *argv[]) {
+  long grammars = 1000, edits = 40;
+  uint64_t seed = 0;
+  if (const char *arg = getFlagValue(argc, argv, "--grammars="))
+    grammars = std::atol(arg);
+  if (const char *arg = getFlagValue(argc, argv, "--edits="))
+    edits = std::atol(arg);
+  if (const char *arg = getFlagValue(argc, argv, "--seed="))
+    seed = std::strtoull(arg, nullptr, 10);
+
+  size_t checks = 0, conflicts = 0;
+  for (long g = 0; g < grammars; g++) {
+    std::mt19937_64 rng(seed + g);
+    int nonterminals = 2 + rng() % 12, terminals = 1 + rng() % 6;
+    std::unique_ptr<Grammar> G(buildGrammar(
+        "N0", randomGrammar(rng, nonterminals, terminals)));
+    // The first edit may come before any analysis or after some of them.
+    int analysed = rng() % 4;
+    if (analysed >= 1)
+      G->getFirstSet(G->getStart());
+    if (analysed >= 2)
+      G->getFollowSet(G->getStart());
+    if (analysed >= 3)
+      G->getAllSelectSet();
+    TableType table;
+    for (long edit = 0; edit < edits; edit++) {
+      if (rng() % 2 || G->productionCount() < 3)
+        addRandomProduction(*G, rng, nonterminals + 3, terminals + 2);
+      else
+        G->removeProduction(rng() % G->productionCount());
+      // Several edits may come between two looks at the analyses, and more
+      // between two updates of the table.
+      if (rng() % 3 == 0)
+        continue;
+      checks++;
+      std::unique_ptr<Grammar> F = rebuild(*G);
+      std::string what = "analyses";
+      std::string got = analysesText(*G), expected = analysesText(*F);
+      if (got == expected && rng() % 2) {
+        TableType full;
+        what = "predict tables";
+        got = predictText(*G, table, true);
+        expected = predictText(*F, full, false);
+        conflicts += expected == "not LL(1)\n";
+      }
+      if (got != expected) {
+        std::cout << "Seed " << seed + g << ", edit " << edit << ": " << what
+                  << " differ\n"
+                  << *G << "--- incremental\n"
+                  << got << "--- rebuilt\n"
+                  << expected;
+        return 1;
+      }
+    }
+  }
+  std::cout << grammars << " grammars, " << checks << " checks, " << conflicts
+            << " not LL(1): no differences\n";
+  return 0;
+}
@@ -0,0 +1,633 @@
+#ifndef COMPILEWORK_LEXER_H
+#define COMPILEWORK_LEXER_H
+
+#include <cctype>
+#include <cstdint>
+#include <iostream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "simd_scan.h"
+
+#ifndef MAX_IDENT_LEN
+#define MAX_IDENT_LEN 8
+#endif
+#ifndef MAX_NUM_LEN
+#define MAX_NUM_LEN 8
+#endif
+
+class Token;
+class Lexer;
+void print_info(Token, std::string_view);
+
+// Thrown for malformed source text, so callers can tell it apart from the
+// parsers' syntax errors.
+class LexError : public std::runtime_error {
+public:
+  using std::runtime_error::runtime_error;
+};
+
+enum TokenType {
+  INVALID_INDENTIFIER,
+  IDENTIFIER,
+  NUMBER,
+  RESERVED_WORD,
+  OPERATOR,
+  SEPERATER,
+  LONG_IDENTIFIER,
+  LONG_NUMBER,
+  END,
+};
+
+enum OperatorType {
+  PLUS,
+  MULTIPY,
+  RELATIONAL,
+};
+
+// BRANCHY_ENGINE is the original isalpha/isdigit/ispunct dispatch, kept so
+// both engines can be timed against the same input.
+enum LexerEngine {
+  BRANCHY_ENGINE,
+  TABLE_ENGINE,
+};
+
+// A token is a slice of the source buffer it was lexed from; the buffer must
+// outlive every token that refers to it.
+class Token {
+public:
+  TokenType type;
+  Token(uint32_t offset, uint32_t length, TokenType type, int lineno)
+      : type(type), lineno(lineno), offset(offset), length(length) {}
+
+  std::string_view getLexeme(std::string_view source) const {
+    return source.substr(offset, length);
+  }
+
+  int getLineno() const { return lineno; }
+  uint32_t getOffset() const { return offset; }
+  uint32_t getLength() const { return length; }
+
+private:
+  int lineno;
+  uint32_t offset, length;
+};
+
+enum SymbolId : uint8_t {
+  NOT_A_SYMBOL,
+  SYM_CONST,
+  SYM_VAR,
+  SYM_PROCEDURE,
+  SYM_BEGIN,
+  SYM_END,
+  SYM_IF,
+  SYM_THEN,
+  SYM_WHILE,
+  SYM_DO,
+  SYM_CALL,
+  SYM_READ,
+  SYM_WRITE,
+  SYM_ODD,
+  SYM_PLUS,
+  SYM_MINUS,
+  SYM_TIMES,
+  SYM_SLASH,
+  SYM_EQUAL,
+  SYM_LESS,
+  SYM_GREATER,
+  SYM_LESS_EQUAL,
+  SYM_GREATER_EQUAL,
+  SYM_NOT_EQUAL,
+  SYM_ASSIGN,
+  SYM_HASH,
+  SYM_PERIOD,
+  SYM_COMMA,
+  SYM_SEMICOLON,
+  SYM_LPAREN,
+  SYM_RPAREN,
+  NUM_SYMBOLS,
+};
+
+// terminal is the single-character name getGrammer() uses for the symbol,
+// op its OperatorType or -1 when it has none.
+struct SymbolInfo {
+  std::string_view text;
+  TokenType type;
+  char terminal;
+  int op;
+};
+
+constexpr SymbolInfo symbolInfo[NUM_SYMBOLS] = {
+    {"", INVALID_INDENTIFIER, 0, -1},
+    {"const", RESERVED_WORD, 'c', -1},
+    {"var", RESERVED_WORD, 'v', -1},
+    {"procedure", RESERVED_WORD, 'p', -1},
+    {"begin", RESERVED_WORD, 's', -1},
+    {"end", RESERVED_WORD, 'e', -1},
+    {"if", RESERVED_WORD, 'i', -1},
+    {"then", RESERVED_WORD, 't', -1},
+    {"while", RESERVED_WORD, 'w', -1},
+    {"do", RESERVED_WORD, 'd', -1},
+    {"call", RESERVED_WORD, 'r', -1},
+    {"read", RESERVED_WORD, 'y', -1},
+    {"write", RESERVED_WORD, 'z', -1},
+    {"odd", RESERVED_WORD, 'o', -1},
+    {"+", OPERATOR, '+', PLUS},
+    {"-", OPERATOR, '-', PLUS},
+    {"*", OPERATOR, '*', MULTIPY},
+    {"/", OPERATOR, '/', MULTIPY},
+    {"=", OPERATOR, '=', RELATIONAL},
+    {"<", OPERATOR, '<', RELATIONAL},
+    {">", OPERATOR, '>', RELATIONAL},
+    {"<=", OPERATOR, 'l', RELATIONAL},
+    {">=", OPERATOR, 'g', RELATIONAL},
+    {"<>", OPERATOR, '<', -1},
+    {":=", OPERATOR, 'x', -1},
+    {"#", OPERATOR, '~', RELATIONAL},
+    {".", SEPERATER, '.', -1},
+    {",", SEPERATER, ',', -1},
+    {";", SEPERATER, ';', -1},
+    {"(", SEPERATER, '(', -1},
+    {")", SEPERATER, ')', -1},
+};
+
+constexpr size_t MAX_SYMBOL_LEN = 9;
+
+// The first, second and last characters plus the length tell every symbol
+// apart; a multiplicative hash then spreads those keys over 64 slots.
+constexpr uint32_t symbolKey(std::string_view str) {
+  return uint32_t(static_cast<unsigned char>(str[0])) << 24 |
+         uint32_t(static_cast<unsigned char>(str[str.size() > 1])) << 16 |
+         uint32_t(static_cast<unsigned char>(str.back())) << 8 |
+         uint32_t(str.size());
+}
+
+struct SymbolHash {
+  uint32_t multiplier;
+  uint8_t slots[64];
+};
+
+// Searches for the first odd multiplier that maps every symbol to its own
+// slot, so the table is collision free by construction.
+constexpr SymbolHash buildSymbolHash() {
+  for (uint32_t m = 1;; m += 2) {
+    SymbolHash h{m, {}};
+    bool perfect = true;
+    for (int id = 1; id < NUM_SYMBOLS && perfect; id++) {
+      uint32_t slot = (symbolKey(symbolInfo[id].text) * m) >> 26;
+      if (h.slots[slot] != NOT_A_SYMBOL)
+        perfect = false;
+      h.slots[slot] = id;
+    }
+    if (perfect)
+      return h;
+  }
+}
+
+constexpr SymbolHash symbolHash = buildSymbolHash();
+
+constexpr SymbolId lookupSymbol(std::string_view str) {
+  if (str.empty() || str.size() > MAX_SYMBOL_LEN)
+    return NOT_A_SYMBOL;
+  auto id = static_cast<SymbolId>(
+      symbolHash.slots[(symbolKey(str) * symbolHash.multiplier) >> 26]);
+  return symbolInfo[id].text == str ? id : NOT_A_SYMBOL;
+}
+
+static_assert(lookupSymbol("procedure") == SYM_PROCEDURE, "");
+static_assert(lookupSymbol(":=") == SYM_ASSIGN, "");
+static_assert(lookupSymbol("proc") == NOT_A_SYMBOL, "");
+
+inline bool isReservedWord(std::string_view str) {
+  return symbolInfo[lookupSymbol(str)].type == RESERVED_WORD;
+}
+
+// Indexed by TokenType.
+const char *const tokenTypeMapper[] = {
+    "非法字符(串)", "标识符", "无符号整数",
+    "保留字",       "运算符", "界符",
+    "标识符长度超长", "无符号整数越界", "",
+};
+
+int dispathOperator(std::string_view op) {
+  int type = symbolInfo[lookupSymbol(op)].op;
+  if (type < 0)
+    throw std::runtime_error("Unexpected op name " + std::string(op));
+  return type;
+}
+
+inline bool isErrorToken(TokenType type) {
+  return type == INVALID_INDENTIFIER || type == LONG_IDENTIFIER ||
+         type == LONG_NUMBER;
+}
+
+// Maps a token onto the single-character terminal used by getGrammer().
+inline char encodeTerminal(TokenType type, std::string_view lexeme) {
+  if (type == IDENTIFIER)
+    return 'b';
+  if (type == NUMBER)
+    return 'n';
+  SymbolId id = lookupSymbol(lexeme);
+  if (id == NOT_A_SYMBOL)
+    return lexeme[0];
+  return symbolInfo[id].terminal;
+}
+
+inline char encodeTerminal(const Token &token, std::string_view source) {
+  return encodeTerminal(token.type, token.getLexeme(source));
+}
+
+void print_info(Token token, std::string_view source) {
+  std::cout << '(';
+  std::cout << tokenTypeMapper[token.type] << ',' << token.getLexeme(source);
+  int lineno = token.getLineno();
+  if (lineno >= 0 && isErrorToken(token.type))
+    std::cout << ',' << "行号:" << lineno;
+  std::cout << ")" << std::endl;
+};
+
+// Numbers are reported by value, so the lexeme starts after any leading
+// zeros; a literal made only of zeros keeps its last one.
+inline size_t skipLeadingZeros(std::string_view code, size_t begin,
+                               size_t end) {
+  while (begin + 1 < end && code[begin] == '0')
+    begin++;
+  return begin;
+}
+
+inline LexerEngine getLexerEngine(int argc, char *argv[]) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--lexer=branchy")
+      return BRANCHY_ENGINE;
+    if (arg == "--lexer=table")
+      return TABLE_ENGINE;
+  }
+  return TABLE_ENGINE;
+}
+
+namespace lexdfa {
+
+enum CharClass : uint8_t {
+  C_LETTER,
+  C_DIGIT,
+  C_BLANK,
+  C_NEWLINE,
+  C_SLASH,
+  C_STAR,
+  C_LT,
+  C_GT,
+  C_COLON,
+  C_EQ,
+  C_OPERATOR,
+  C_SEPERATER,
+  C_PUNCT,
+  C_OTHER,
+  NUM_CLASSES,
+};
+
+// S_START doubles as the state for blanks and finished comments: every
+// transition back into it restarts the lexeme.
+enum State : uint8_t {
+  S_START,
+  S_IDENT,
+  S_NUMBER,
+  S_NUMBER_TAIL,
+  S_LT,
+  S_GT,
+  S_COLON,
+  S_OPERATOR2,
+  S_OPERATOR1,
+  S_SLASH,
+  S_SEPERATER,
+  S_INVALID,
+  S_LINE_COMMENT,
+  S_BLOCK_COMMENT,
+  S_BLOCK_STAR,
+  NUM_STATES,
+  S_DONE = NUM_STATES,
+};
+
+struct Tables {
+  uint8_t charClass[256];
+  uint8_t next[NUM_STATES][NUM_CLASSES];
+};
+
+constexpr Tables buildTables() {
+  Tables t{};
+  for (int c = 0; c < 256; c++) {
+    uint8_t cls = C_OTHER;
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+      cls = C_LETTER;
+    else if (c >= '0' && c <= '9')
+      cls = C_DIGIT;
+    else if (c == ' ' || c == '\t' || c == '\v' || c == '\f' || c == '\r')
+      cls = C_BLANK;
+    else if (c == '\n')
+      cls = C_NEWLINE;
+    else if (c == '/')
+      cls = C_SLASH;
+    else if (c == '*')
+      cls = C_STAR;
+    else if (c == '<')
+      cls = C_LT;
+    else if (c == '>')
+      cls = C_GT;
+    else if (c == ':')
+      cls = C_COLON;
+    else if (c == '=')
+      cls = C_EQ;
+    else if (c == '+' || c == '-' || c == '#')
+      cls = C_OPERATOR;
+    else if (c == '.' || c == ',' || c == ';' || c == '(' || c == ')')
+      cls = C_SEPERATER;
+    else if (c > ' ' && c < 127)
+      cls = C_PUNCT;
+    t.charClass[c] = cls;
+  }
+
+  for (int s = 0; s < NUM_STATES; s++)
+    for (int c = 0; c < NUM_CLASSES; c++)
+      t.next[s][c] = S_DONE;
+
+  auto &start = t.next[S_START];
+  start[C_LETTER] = S_IDENT;
+  start[C_DIGIT] = S_NUMBER;
+  start[C_BLANK] = S_START;
+  start[C_NEWLINE] = S_START;
+  start[C_SLASH] = S_SLASH;
+  start[C_STAR] = S_OPERATOR1;
+  start[C_LT] = S_LT;
+  start[C_GT] = S_GT;
+  start[C_COLON] = S_COLON;
+  start[C_EQ] = S_OPERATOR1;
+  start[C_OPERATOR] = S_OPERATOR1;
+  start[C_SEPERATER] = S_SEPERATER;
+  start[C_PUNCT] = S_INVALID;
+
+  t.next[S_IDENT][C_LETTER] = S_IDENT;
+  t.next[S_IDENT][C_DIGIT] = S_IDENT;
+  t.next[S_NUMBER][C_DIGIT] = S_NUMBER;
+  t.next[S_NUMBER][C_LETTER] = S_NUMBER_TAIL;
+  t.next[S_LT][C_EQ] = S_OPERATOR2;
+  t.next[S_GT][C_EQ] = S_OPERATOR2;
+  t.next[S_COLON][C_EQ] = S_OPERATOR2;
+  t.next[S_SLASH][C_STAR] = S_BLOCK_COMMENT;
+  t.next[S_SLASH][C_SLASH] = S_LINE_COMMENT;
+
+  for (int c = 0; c < NUM_CLASSES; c++) {
+    t.next[S_LINE_COMMENT][c] = S_LINE_COMMENT;
+    t.next[S_BLOCK_COMMENT][c] = S_BLOCK_COMMENT;
+    t.next[S_BLOCK_STAR][c] = S_BLOCK_COMMENT;
+  }
+  t.next[S_LINE_COMMENT][C_NEWLINE] = S_START;
+  t.next[S_BLOCK_COMMENT][C_STAR] = S_BLOCK_STAR;
+  t.next[S_BLOCK_STAR][C_STAR] = S_BLOCK_STAR;
+  t.next[S_BLOCK_STAR][C_SLASH] = S_START;
+  return t;
+}
+
+constexpr Tables tables = buildTables();
+
+// Advances the DFA over src[pos, end) until it rejects a byte or the input
+// runs out. Returns true when the token ends at pos. Every return to S_START
+// moves start past the blanks or comment just skipped.
+inline bool scan(const char *src, size_t &pos, size_t end, uint8_t &state,
+                 size_t &start, int &line) {
+  while (pos < end) {
+    uint8_t cls = tables.charClass[static_cast<unsigned char>(src[pos])];
+    uint8_t next = tables.next[state][cls];
+    if (next == S_DONE)
+      return true;
+    line += cls == C_NEWLINE;
+    state = next;
+    pos++;
+    // Blanks and comment bodies never end a token, so they are skipped in
+    // bulk instead of one transition per byte.
+    if (state == S_START) {
+      pos = simdscan::skipBlanks(src, pos, end, line);
+      start = pos;
+    } else if (state == S_LINE_COMMENT) {
+      pos = simdscan::findNewline(src, pos, end);
+    } else if (state == S_BLOCK_COMMENT) {
+      pos = simdscan::findCommentClose(src, pos, end, line);
+    }
+  }
+  return false;
+}
+
+inline bool isSkipState(uint8_t state) {
+  return state == S_START || state == S_LINE_COMMENT ||
+         state == S_BLOCK_COMMENT || state == S_BLOCK_STAR;
+}
+
+// Classifies the token the DFA stopped on. code[start, end) is the consumed
+// text, and end == code.size() means the input is exhausted; start is moved
+// past the leading zeros of a number.
+inline TokenType acceptState(uint8_t state, std::string_view code,
+                             size_t &start, size_t end) {
+  switch (state) {
+  case S_START:
+    if (end >= code.size())
+      return END;
+    throw LexError("Unreached statement");
+  case S_LINE_COMMENT:
+    return END;
+  case S_BLOCK_COMMENT:
+  case S_BLOCK_STAR:
+    throw LexError("Unclosed block comment");
+  case S_IDENT:
+    if (isReservedWord(code.substr(start, end - start)))
+      return RESERVED_WORD;
+    return end - start > MAX_IDENT_LEN ? LONG_IDENTIFIER : IDENTIFIER;
+  case S_NUMBER:
+  case S_NUMBER_TAIL: {
+    bool has_tail = state == S_NUMBER_TAIL;
+    size_t digits_end = end - has_tail;
+    start = skipLeadingZeros(code, start, digits_end);
+    if (digits_end - start > MAX_NUM_LEN)
+      return LONG_NUMBER;
+    return has_tail ? INVALID_INDENTIFIER : NUMBER;
+  }
+  case S_LT:
+  case S_GT:
+  case S_OPERATOR1:
+  case S_OPERATOR2:
+  case S_SLASH:
+    return OPERATOR;
+  case S_SEPERATER:
+    return SEPERATER;
+  default:
+    return INVALID_INDENTIFIER;
+  }
+}
+
+} // namespace lexdfa
+
+class Lexer {
+public:
+  Lexer(std::string_view code, LexerEngine engine = TABLE_ENGINE)
+      : code(code), pos(0), lexemeStart(0), lexemeLength(0), cur_line(1),
+        engine(engine) {
+    if (code.size() > UINT32_MAX)
+      throw std::runtime_error("Source larger than 4GiB");
+  }
+
+  TokenType getTokenType() {
+    if (engine == TABLE_ENGINE)
+      return scanToken();
+    skipWhiteSpaceAndComments();
+    if (pos >= code.size())
+      return END;
+    char ch = code[pos];
+    if (isalpha(ch))
+      return identifyIdentifierOrKeyword();
+    if (isdigit(ch))
+      return identifyNumber();
+    if (ispunct(ch))
+      return identifyOperatorOrSeperater();
+    throw LexError("Unreached statement");
+  }
+
+  Token buildToken(TokenType type) {
+    return Token(lexemeStart, lexemeLength, type, cur_line);
+  }
+
+  std::string_view getLexeme(const Token &token) const {
+    return token.getLexeme(code);
+  }
+
+  std::string_view getSource() const { return code; }
+
+private:
+  TokenType scanToken() {
+    using namespace lexdfa;
+    size_t start = pos;
+    uint8_t state = S_START;
+    scan(code.data(), pos, code.size(), state, start, cur_line);
+    TokenType type = acceptState(state, code, start, pos);
+    setLexeme(start, pos);
+    return type;
+  }
+
+  void skipWhiteSpaceAndComments() {
+    while (pos < code.size()) {
+      pos = simdscan::skipBlanks(code.data(), pos, code.size(), cur_line);
+      if (pos + 1 >= code.size() || code[pos] != '/')
+        return;
+      char next_ch = code[pos + 1];
+      if (next_ch == '*') {
+        skipBlockComment();
+      } else if (next_ch == '/') {
+        skipLineComment();
+      } else {
+        return;
+      }
+    }
+  }
+
+  void skipBlockComment() {
+    pos = simdscan::findCommentClose(code.data(), pos + 2, code.size(),
+                                     cur_line);
+    if (pos + 1 >= code.size())
+      throw LexError("Unclosed block comment");
+    pos += 2;
+  }
+
+  void skipLineComment() {
+    pos = simdscan::findNewline(code.data(), pos + 2, code.size());
+  }
+
+  TokenType identifyIdentifierOrKeyword() {
+    size_t begin = pos;
+    bool is_too_long = false;
+    while (pos < code.size() && isalnum(code[pos])) {
+      pos++;
+    }
+    if (pos - begin > MAX_IDENT_LEN)
+      is_too_long = true;
+
+    setLexeme(begin, pos);
+    if (isReservedWord(code.substr(begin, pos - begin)))
+      return RESERVED_WORD;
+    if (is_too_long)
+      return LONG_IDENTIFIER;
+    return IDENTIFIER;
+  }
+
+  TokenType identifyNumber() {
+    bool is_too_long = false;
+    bool is_invalid = false;
+    size_t begin = pos;
+    while (pos < code.size() && isdigit(code[pos])) {
+      pos++;
+    }
+    begin = skipLeadingZeros(code, begin, pos);
+    if (pos - begin > MAX_NUM_LEN)
+      is_too_long = true;
+    if (pos < code.size() && isalnum(code[pos])) {
+      is_invalid = true;
+      pos++;
+    }
+    setLexeme(begin, pos);
+    if (is_too_long)
+      return LONG_NUMBER;
+    if (is_invalid)
+      return INVALID_INDENTIFIER;
+    return NUMBER;
+  }
+
+  TokenType identifyOperatorOrSeperater() {
+    char ch = code[pos];
+    if (ch == '<') {
+      if (pos + 1 < code.size() && code[pos + 1] == '=') {
+        return advance(OPERATOR, 2);
+      } else {
+        return advance(OPERATOR);
+      }
+    }
+    if (ch == '>') {
+      if (pos + 1 < code.size() && code[pos + 1] == '=') {
+        return advance(OPERATOR, 2);
+      } else {
+        return advance(OPERATOR);
+      }
+    }
+    if (ch == ':' && pos + 1 < code.size() && code[pos + 1] == '=') {
+      return advance(OPERATOR, 2);
+    }
+    TokenType type = symbolInfo[lookupSymbol(code.substr(pos, 1))].type;
+    if (type == OPERATOR || type == SEPERATER) {
+      return advance(type);
+    }
+    return advance(INVALID_INDENTIFIER);
+  }
+
+  TokenType advance(TokenType type) {
+    setLexeme(pos, pos + 1);
+    pos++;
+    return type;
+  }
+
+  TokenType advance(TokenType type, int step) {
+    setLexeme(pos, pos + step);
+    pos += step;
+    return type;
+  }
+
+  void setLexeme(size_t begin, size_t end) {
+    lexemeStart = begin;
+    lexemeLength = end - begin;
+  }
+
+private:
+  std::string_view code;
+  size_t pos;
+  uint32_t lexemeStart, lexemeLength;
+  int cur_line;
+  LexerEngine engine;
+};
+
+#endif
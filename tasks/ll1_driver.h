@@ -0,0 +1,327 @@
+#ifndef COMPILEWORK_LL1_DRIVER_H
+#define COMPILEWORK_LL1_DRIVER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "grammar.h"
+#include "parse_tree.h"
+#include "table_image.h"
+
+// The LL(1) parse loop on dense integer tables. The predict table is one
+// int16_t array of production ids, a row per nonterminal and a column per
+// terminal. Every right-hand side is laid out once, reversed, so that an
+// expansion copies it onto the stack as it is. Stack entries are a
+// nonterminal's row r as r and a terminal's column t as ~t. The stack is
+// kept from one parse to the next and only grows, so once it has been as
+// deep as the input needs a parse allocates nothing.
+//
+// A syntax error is recovered from in panic mode by taking one symbol as
+// missing where that lets the stack take the lookahead, and otherwise
+// dropping the lookahead. The missing symbol is the first terminal of a
+// production of the nonterminal on top, or the top itself, or with a
+// nullable nonterminal on top one under it; nullable nonterminals on the
+// way derive the empty string, leaving the error to the symbols under them.
+class LL1Driver {
+public:
+  // POP and SKIP are the repairs of a syntax error.
+  enum Action { EXPAND, MATCH, ACCEPT, POP, SKIP, DELEGATE };
+  static constexpr int NO_COLUMN = -1, NO_ROW = -1;
+  static constexpr size_t INITIAL_DEPTH = 256;
+
+  LL1Driver(Grammar &G, const PredictCells &table)
+      : width(G.getSymbols().terminals().size()) {
+    const SymbolTable &symbols = G.getSymbols();
+    if (G.productionCount() > size_t(std::numeric_limits<int16_t>::max()))
+      throw std::runtime_error("Too many productions for an int16_t table");
+    rows = symbols.nonterminals();
+    columns = symbols.terminals();
+    cells.resize(rows.size() * width);
+    first.resize(rows.size() * width);
+    empty.assign(rows.size(), NO_RULE);
+    openers.resize(rows.size());
+    int epsilon = symbols.index(SymbolTable::EPSILON);
+    for (size_t non = 0; non < rows.size(); non++) {
+      for (size_t t = 0; t < width; t++)
+        cells[non * width + t] = table(non, t);
+      const TerminalSet &starters = G.getFirstSet(rows[non]);
+      for (int t : starters)
+        first[non * width + t] = t != epsilon;
+      for (int rule : G.getRules(rows[non])) {
+        SymbolSpan rhs = G.getRhs(rule);
+        if (!rhs.empty() && !symbols.isNonterminal(rhs[0]))
+          openers[non].push_back(rule);
+      }
+      if (!starters.contains(epsilon))
+        continue;
+      // What the table predicts on FOLLOW derives the empty string.
+      for (int t : G.getFollowSet(rows[non]))
+        empty[non] = cells[non * width + t];
+    }
+    starts.reserve(G.productionCount() + 1);
+    starts.push_back(0);
+    for (size_t rule = 0; rule < G.productionCount(); rule++) {
+      SymbolSpan rhs = G.getRhs(rule);
+      for (size_t i = rhs.size(); i-- > 0;) {
+        int index = symbols.index(rhs[i]);
+        reversed.push_back(symbols.isNonterminal(rhs[i]) ? index : ~index);
+      }
+      starts.push_back(reversed.size());
+    }
+    by_char.fill(NO_COLUMN);
+    for (Symbol t : columns) {
+      const std::string &name = symbols.name(t);
+      if (name.size() == 1)
+        by_char[static_cast<unsigned char>(name[0])] = symbols.index(t);
+      else
+        by_name[name] = symbols.index(t);
+    }
+    start_row = symbols.index(G.getStart());
+    end_column = symbols.index(SymbolTable::END);
+    stack.reserve(INITIAL_DEPTH);
+  }
+
+  // The column of the terminal called name, or NO_COLUMN.
+  int column(const std::string &name) const {
+    if (name.size() == 1)
+      return by_char[static_cast<unsigned char>(name[0])];
+    auto it = by_name.find(name);
+    return it == by_name.end() ? NO_COLUMN : it->second;
+  }
+
+  // The production for nonterminal index non on terminal index t, or
+  // NO_RULE.
+  int rule(int non, int t) const { return cells[size_t(non) * width + t]; }
+
+  void clear() { stack.clear(); }
+
+  // Leaves the nonterminal of row to another parser: step() pops it and
+  // returns DELEGATE instead of expanding it. NO_ROW hands none over.
+  void delegate(int row) { delegated = row; }
+
+  // Makes parse() and next() build the parse tree into tree, or no tree if
+  // it is null.
+  void build(ParseTree *tree) { this->tree = tree; }
+
+  // Sets the stack up for a new parse: the end marker under the start
+  // symbol.
+  void start() {
+    stack.clear();
+    stack.push_back(~end_column);
+    stack.push_back(start_row);
+  }
+
+  // Decides the next step on lookahead column t. An expansion replaces the
+  // nonterminal on top by its production, which rule is set to. A terminal
+  // on top that matches t is left for match(), so the caller can look at
+  // the input before it moves on. When t does not fit, a nonterminal may be
+  // expanded by a production whose first terminal is missing, or to the
+  // empty string, and POP has taken a missing symbol off the stack. If
+  // nothing is missing that would let the stack take t, SKIP leaves t for
+  // skip().
+  Action step(int t, int &rule) {
+    int top = stack.back();
+    if (top >= 0) {
+      if (top == delegated) {
+        stack.pop_back();
+        return DELEGATE;
+      }
+      rule = t == NO_COLUMN ? NO_RULE : cells[size_t(top) * width + t];
+      if (rule == NO_RULE && (rule = recover(top, t)) == NO_RULE)
+        return t == end_column || resumes(t, 0) ? pop() : SKIP;
+      stack.pop_back();
+      stack.insert(stack.end(), reversed.begin() + starts[rule],
+                   reversed.begin() + starts[rule + 1]);
+      return EXPAND;
+    }
+    if (~top == t)
+      return t == end_column ? ACCEPT : MATCH;
+    return t == end_column || resumes(t, 0) ? pop() : SKIP;
+  }
+
+  // Pops the terminal step() matched and consumes it.
+  template <typename Input> void match(Input &input) {
+    stack.pop_back();
+    input.advance();
+  }
+
+  // Drops the lookahead step() could not use.
+  template <typename Input> void skip(Input &input) { input.advance(); }
+
+  // Sets up a parse of input by next(), building the tree if there is one.
+  template <typename Input> void begin(Input &input) {
+    start();
+    if (tree)
+      tree->clear();
+    panic = false;
+    lookahead = column(input.peek());
+  }
+
+  // Takes the next step of the parse begun with begin() and carries it out,
+  // rule being set as by step(). A syntax error calls error(input) with the
+  // input at the error and the parse goes on in panic mode; the errors that
+  // follow before a terminal is matched again are taken as part of it. The
+  // delegated nonterminal is parsed by other(input), which tells whether the
+  // tokens it took were a sentence of it.
+  template <typename Input, typename Error, typename Other>
+  Action next(Input &input, Error &error, Other &other, int &rule) {
+    int top = stack.back();
+    Action action = step(lookahead, rule);
+    if (tree)
+      record(*tree, action, top, rule, input.position());
+    if (action == EXPAND)
+      return action;
+    if (action == ACCEPT) {
+      if (tree)
+        tree->finish();
+      return action;
+    }
+    if (action == MATCH) {
+      match(input);
+      panic = false;
+    } else if (action == DELEGATE && other(input)) {
+      panic = false;
+    } else {
+      if (!panic)
+        error(input);
+      panic = true;
+      if (action == SKIP)
+        skip(input);
+    }
+    lookahead = column(input.peek());
+    return action;
+  }
+
+  // Parses input to the end with next() and returns how many productions it
+  // expanded.
+  template <typename Input, typename Error, typename Other>
+  size_t parse(Input &input, Error error, Other other) {
+    begin(input);
+    size_t expansions = 0;
+    for (int rule;;) {
+      Action action = next(input, error, other, rule);
+      if (action == EXPAND)
+        expansions++;
+      else if (action == ACCEPT)
+        return expansions;
+    }
+  }
+
+  template <typename Input, typename Error>
+  size_t parse(Input &input, Error error) {
+    return parse(input, error, [](Input &) { return false; });
+  }
+
+  // Parses input, which must be a sentence, and returns how many
+  // productions it expanded.
+  template <typename Input> size_t parse(Input &input) {
+    return parse(input, [](Input &) {
+      throw std::runtime_error("PredictTable wrong!\n");
+    });
+  }
+
+  // The stack bottom up, as grammar symbols, for traces.
+  size_t depth() const { return stack.size(); }
+  Symbol symbolAt(size_t i) const {
+    return stack[i] >= 0 ? rows[stack[i]] : columns[~stack[i]];
+  }
+
+private:
+  // Takes the top off the stack as missing.
+  Action pop() {
+    stack.pop_back();
+    return POP;
+  }
+
+  // The production to expand nonterminal row non by when the table has none
+  // on lookahead column t: one whose first terminal is missing, or the
+  // empty string if the stack under it takes t with one symbol missing.
+  // NO_RULE if non itself must be missing or t dropped.
+  int recover(int non, int t) const {
+    int rule = repair(non, t);
+    if (rule == NO_RULE && empty[non] != NO_RULE &&
+        (t == end_column || resumes(t, 1)))
+      rule = empty[non];
+    return rule;
+  }
+
+  // A production of nonterminal row non that takes lookahead column t once
+  // its first terminal is taken as missing, or NO_RULE.
+  int repair(int non, int t) const {
+    for (int rule : openers[non]) {
+      const int *first = reversed.data() + starts[rule + 1] - 1;
+      if (resumes(reversed.data() + starts[rule], first, t, 0))
+        return rule;
+    }
+    return NO_RULE;
+  }
+
+  // Whether the stack under the top takes lookahead column t with up to
+  // missing symbols given up.
+  bool resumes(int t, int missing) const {
+    return resumes(stack.data(), stack.data() + stack.size() - 1, t, missing);
+  }
+
+  // Whether the entries from end - 1 down to begin, laid out as the stack,
+  // take lookahead column t once nullable nonterminals derive the empty
+  // string and up to missing others are given up. A nonterminal takes t if
+  // t can start it, not if it may only follow it.
+  bool resumes(const int *begin, const int *end, int t, int missing) const {
+    if (t == NO_COLUMN)
+      return false;
+    while (end-- > begin) {
+      int entry = *end;
+      if (entry >= 0 ? first[size_t(entry) * width + t] : ~entry == t)
+        return true;
+      if ((entry < 0 || empty[entry] == NO_RULE) && missing-- == 0)
+        return false;
+    }
+    return false;
+  }
+
+  // Adds to tree what step() did with top, the stack entry it saw, given
+  // the rule it set and the input position of the lookahead. A delegated
+  // nonterminal and one given up are leaves.
+  void record(ParseTree &tree, Action action, int top, int rule,
+              size_t position) const {
+    if (action == EXPAND)
+      tree.expand(rows[top], rule, starts[rule + 1] - starts[rule]);
+    else if (action == MATCH)
+      tree.leaf(columns[~top], position);
+    else if (action == POP && top < 0)
+      tree.leaf(columns[~top], ParseTree::NO_TOKEN);
+    else if (action == POP || action == DELEGATE)
+      tree.leaf(rows[top], NO_RULE);
+  }
+
+  size_t width;
+  std::vector<int16_t> cells;
+  // Whether the terminal of a column can start the nonterminal of a row,
+  // laid out as cells.
+  std::vector<bool> first;
+  // The production a nullable nonterminal derives the empty string by, or
+  // NO_RULE, and the productions that start with a terminal, by row.
+  std::vector<int> empty;
+  std::vector<std::vector<int>> openers;
+  // The reversed right-hand side of production r is
+  // reversed[starts[r]] up to reversed[starts[r + 1]].
+  std::vector<int> reversed;
+  std::vector<uint32_t> starts;
+  std::vector<Symbol> rows, columns;
+  std::array<int, 256> by_char;
+  std::unordered_map<std::string, int> by_name;
+  int start_row, end_column, delegated = NO_ROW;
+  // The lookahead column and the panic mode of the parse next() is taking.
+  int lookahead;
+  bool panic;
+  ParseTree *tree = nullptr;
+  std::vector<int> stack;
+};
+
+#endif
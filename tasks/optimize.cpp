@@ -0,0 +1,96 @@
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "grammar.h"
+#include "pl0_grammar.h"
+#include "predict_table.h"
+#include "source.h"
+#include "token_source.h"
+
+// Runs Grammar::optimize() over the PL/0 grammar and shows what it changed:
+//
+//   optimize [--grammar] [FILE]
+//
+// For the grammar before and after it prints the nonterminals (the rows and
+// so the states of the predict table), the productions, the table's cells
+// and how many are filled, and the expansions the parse of the program in
+// FILE, or on standard input, takes. --grammar also prints the optimised
+// productions. A program with syntax errors has no parse to count, so the
+// lines with errors are printed instead, as task2 does.
+
+struct GrammarStats {
+  size_t nonterminals = 0, productions = 0, cells = 0, filled = 0,
+         expansions = 0;
+  // Lines of the program's syntax errors.
+  std::vector<int> errors;
+};
+
+GrammarStats measure(Grammar &G, std::string_view source) {
+  GrammarStats stats;
+  stats.nonterminals = G.getSymbols().nonterminals().size();
+  stats.productions = G.productionCount();
+  TableType table;
+  buildPredcitTable(G, table);
+  for (const auto &row : table) {
+    stats.cells += row.size();
+    for (int rule : row)
+      stats.filled += rule != NO_RULE;
+  }
+  PredictTable parser(G);
+  TokenSource tokens(source);
+  stats.errors = parser.analysis(tokens, false);
+  stats.expansions = parser.expansionCount();
+  return stats;
+}
+
+int main(int argc, char *argv[]) {
+  std::string code, line;
+  MappedFile file;
+  const char *path = getSourcePath(argc, argv);
+  if (path) {
+    file.open(path);
+  } else {
+    while (std::getline(std::cin, line)) {
+      code += line;
+      if (line.size() > 0 && line.back() == '.') {
+        break;
+      }
+      code += '\n';
+    }
+  }
+  std::string_view source = path ? file.view() : std::string_view(code);
+
+  std::unique_ptr<Grammar> G(getGrammer());
+  GrammarStats before = measure(*G, source);
+  if (!before.errors.empty()) {
+    for (int line : before.errors)
+      std::cout << "(语法错误,行号:" << line << ")" << std::endl;
+    return 1;
+  }
+  G->optimize();
+  GrammarStats after = measure(*G, source);
+  // The optimised grammar must accept what the original did.
+  if (!after.errors.empty())
+    throw std::runtime_error("Optimised grammar rejects the program\n");
+  if (hasFlag(argc, argv, "--grammar"))
+    std::cout << *G;
+
+  auto row = [](const char *name, size_t before, size_t after) {
+    std::cout << std::left << std::setw(14) << name << std::right
+              << std::setw(8) << before << std::setw(8) << after << '\n';
+  };
+  std::cout << std::left << std::setw(14) << "" << std::right << std::setw(8)
+            << "before" << std::setw(8) << "after" << '\n';
+  row("nonterminals", before.nonterminals, after.nonterminals);
+  row("productions", before.productions, after.productions);
+  row("table cells", before.cells, after.cells);
+  row("filled cells", before.filled, after.filled);
+  row("expansions", before.expansions, after.expansions);
+  return 0;
+}
@@ -0,0 +1,177 @@
+#ifndef COMPILEWORK_PARALLEL_LEXER_H
+#define COMPILEWORK_PARALLEL_LEXER_H
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "lexer.h"
+#include "token_buffer.h"
+
+// Splitting the source right after a newline keeps the parallel lexer simple:
+// no token contains a newline and a line comment ends at one, so every chunk
+// starts either in S_START or inside a block comment. A token's line is one
+// plus the newlines before it, whichever way the chunk started, so chunks
+// count lines from 1 and are rebased once the chunk line counts are known.
+namespace parlex {
+
+constexpr size_t MIN_CHUNK_SIZE = 1 << 16;
+
+struct ChunkResult {
+  TokenBuffer tokens;
+  bool endsInComment = false;
+  std::exception_ptr error;
+};
+
+struct Chunk {
+  size_t begin, end;
+  int lines;
+  ChunkResult outside, inside;
+};
+
+inline bool sameToken(const TokenBuffer &tokens, size_t i, const Token &b) {
+  return tokens.offset(i) == b.getOffset() &&
+         tokens.length(i) == b.getLength() && tokens.kind(i) == b.type;
+}
+
+// Lexes source[pos, end) from S_START. Once a token matches one already
+// produced by the other hypothesis of this chunk the two runs are on the same
+// DFA path, so the rest of that run is reused instead of lexed again.
+inline void lexChunk(std::string_view source, size_t pos, size_t end, int line,
+                     ChunkResult &out, const ChunkResult *converge) {
+  using namespace lexdfa;
+  std::string_view code = source.substr(0, end);
+  bool is_last = end == source.size();
+  size_t j = 0;
+  try {
+    while (true) {
+      size_t start = pos;
+      uint8_t state = S_START;
+      if (!scan(code.data(), pos, end, state, start, line) && !is_last) {
+        out.endsInComment =
+            state == S_BLOCK_COMMENT || state == S_BLOCK_STAR;
+        return;
+      }
+      TokenType type = acceptState(state, code, start, pos);
+      if (type == END)
+        return;
+      Token token(start, pos - start, type, line);
+      if (converge) {
+        auto &other = converge->tokens;
+        while (j < other.size() && other.offset(j) < start)
+          j++;
+        if (j < other.size() && sameToken(other, j, token)) {
+          out.tokens.append(other, j);
+          out.endsInComment = converge->endsInComment;
+          out.error = converge->error;
+          return;
+        }
+      }
+      out.tokens.push_back(token);
+    }
+  } catch (...) {
+    out.error = std::current_exception();
+  }
+}
+
+// Lexes one chunk under both possible start states.
+inline void lexBothWays(std::string_view source, Chunk &chunk) {
+  const char *src = source.data();
+  chunk.lines = std::count(src + chunk.begin, src + chunk.end, '\n');
+  chunk.outside.tokens.reserve(estimateTokenCount(chunk.end - chunk.begin));
+  lexChunk(source, chunk.begin, chunk.end, 1, chunk.outside, nullptr);
+  if (chunk.begin == 0)
+    return;
+
+  size_t close = chunk.begin;
+  while (close + 1 < chunk.end &&
+         !(src[close] == '*' && src[close + 1] == '/'))
+    close++;
+  if (close + 1 >= chunk.end) {
+    chunk.inside.endsInComment = true;
+    if (chunk.end == source.size())
+      chunk.inside.error =
+          std::make_exception_ptr(LexError("Unclosed block comment"));
+    return;
+  }
+  int line = 1 + std::count(src + chunk.begin, src + close, '\n');
+  lexChunk(source, close + 2, chunk.end, line, chunk.inside, &chunk.outside);
+}
+
+} // namespace parlex
+
+// Produces the same tokens as running the table-driven Lexer over source,
+// using up to threads worker threads (0 picks one per core). Inputs smaller
+// than min_chunk per thread use fewer threads.
+inline TokenBuffer
+lexParallel(std::string_view source, unsigned threads = 0,
+            size_t min_chunk = parlex::MIN_CHUNK_SIZE) {
+  using namespace parlex;
+  if (source.size() > UINT32_MAX)
+    throw std::runtime_error("Source larger than 4GiB");
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  size_t parts = std::min<size_t>(threads, source.size() / min_chunk + 1);
+
+  std::vector<Chunk> chunks;
+  size_t begin = 0;
+  for (size_t i = 1; i <= parts && begin < source.size(); i++) {
+    size_t end = source.size();
+    if (i < parts) {
+      end = std::max(begin, source.size() / parts * i);
+      const void *nl =
+          std::memchr(source.data() + end, '\n', source.size() - end);
+      end = nl ? static_cast<const char *>(nl) - source.data() + 1
+               : source.size();
+    }
+    chunks.push_back({begin, end, 0, {}, {}});
+    begin = end;
+  }
+
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < chunks.size(); i++)
+    workers.emplace_back(lexBothWays, source, std::ref(chunks[i]));
+  if (!chunks.empty())
+    lexBothWays(source, chunks[0]);
+  for (auto &worker : workers)
+    worker.join();
+
+  std::vector<ChunkResult *> picked;
+  std::vector<size_t> first_token;
+  std::vector<int> base_line;
+  size_t total = 0;
+  int line = 0;
+  bool in_comment = false;
+  for (auto &chunk : chunks) {
+    ChunkResult &result = in_comment ? chunk.inside : chunk.outside;
+    if (result.error)
+      std::rethrow_exception(result.error);
+    picked.push_back(&result);
+    first_token.push_back(total);
+    base_line.push_back(line);
+    total += result.tokens.size();
+    line += chunk.lines;
+    in_comment = result.endsInComment;
+  }
+
+  if (picked.size() == 1)
+    return std::move(picked[0]->tokens);
+  TokenBuffer tokens;
+  tokens.resize(total);
+  auto rebase = [&](size_t i) {
+    tokens.place(first_token[i], picked[i]->tokens, base_line[i]);
+  };
+  workers.clear();
+  for (size_t i = 1; i < picked.size(); i++)
+    workers.emplace_back(rebase, i);
+  if (!picked.empty())
+    rebase(0);
+  for (auto &worker : workers)
+    worker.join();
+  return tokens;
+}
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef COMPILEWORK_PARSE_TREE_H
+#define COMPILEWORK_PARSE_TREE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "grammar.h"
+
+// A node of a ParseTree.
+struct ParseNode {
+  Symbol symbol;
+  // For a nonterminal its production, or NO_RULE if the parse gave it up
+  // or left it to another parser; for a terminal the input position of its
+  // token, or ParseTree::NO_TOKEN if it was missing.
+  int value;
+  // Direct children, and nodes in the subtree including this one.
+  uint32_t children, size;
+};
+
+// A parse tree in one array, in preorder: the root is first, the first
+// child of node i is i + 1 and the next sibling of child c is c + its size.
+// Nodes refer to each other only by position, so building a tree is
+// appending to an array that is kept from one parse to the next.
+//
+// A top-down parser finds the nodes in preorder and appends them with
+// expand() and leaf(). A bottom-up parser finds them in postorder and
+// records them with shift() and reduce(). Either way finish() then makes
+// the array the tree: it works out the sizes after a top-down parse, and
+// puts the nodes of a bottom-up one in preorder.
+class ParseTree {
+public:
+  static constexpr int NO_TOKEN = -1;
+
+  void clear() {
+    nodes.clear();
+    roots.clear();
+  }
+
+  // Top-down: nonterminal non is derived by rule into children symbols,
+  // whose subtrees come next.
+  void expand(Symbol non, int rule, uint32_t children) {
+    nodes.push_back({non, rule, children, 0});
+  }
+
+  // Top-down: a node without children, a terminal or a nonterminal that
+  // was not expanded.
+  void leaf(Symbol symbol, int value) {
+    nodes.push_back({symbol, value, 0, 1});
+  }
+
+  // Bottom-up: terminal t was shifted from input position token.
+  void shift(Symbol t, int token) {
+    roots.push_back(nodes.size());
+    nodes.push_back({t, token, 0, 1});
+  }
+
+  // Bottom-up: the last children subtrees were reduced to non by rule.
+  void reduce(Symbol non, int rule, uint32_t children) {
+    uint32_t size = 1;
+    for (size_t i = roots.size() - children; i < roots.size(); i++)
+      size += nodes[roots[i]].size;
+    roots.resize(roots.size() - children);
+    roots.push_back(nodes.size());
+    nodes.push_back({non, rule, children, size});
+  }
+
+  // Completes the tree once the parse has accepted.
+  void finish() {
+    if (roots.empty())
+      sizeSubtrees();
+    else
+      reorder();
+  }
+
+  bool empty() const { return nodes.empty(); }
+  size_t size() const { return nodes.size(); }
+  const ParseNode &operator[](size_t i) const { return nodes[i]; }
+  static constexpr size_t root() { return 0; }
+
+  // Appends the positions of the children of node to out, left to right.
+  void children(size_t node, std::vector<size_t> &out) const {
+    size_t child = node + 1;
+    for (uint32_t n = nodes[node].children; n > 0; n--) {
+      out.push_back(child);
+      child += nodes[child].size;
+    }
+  }
+
+  // One node per line, indented by depth, with a terminal's token position
+  // after its name.
+  void print(std::ostream &os, const SymbolTable &symbols) const {
+    // Children still to come on each open level.
+    std::vector<uint32_t> open;
+    for (const ParseNode &n : nodes) {
+      os << std::string(2 * open.size(), ' ') << symbols.name(n.symbol);
+      if (!symbols.isNonterminal(n.symbol))
+        os << " @" << n.value;
+      os << '\n';
+      if (n.children > 0) {
+        open.push_back(n.children);
+        continue;
+      }
+      while (!open.empty() && --open.back() == 0)
+        open.pop_back();
+    }
+  }
+
+private:
+  // Sizes from the end. starts holds where the subtrees found so far
+  // begin, nearest on top, above the end of the array. The subtrees of a
+  // node's children are the ones on top, and its own subtree ends where
+  // the one below them begins.
+  void sizeSubtrees() {
+    std::vector<uint32_t> &starts = scratch;
+    starts.resize(nodes.size() + 1);
+    starts[0] = nodes.size();
+    size_t depth = 1;
+    for (size_t i = nodes.size(); i-- > 0;) {
+      depth -= nodes[i].children;
+      nodes[i].size = starts[depth - 1] - i;
+      starts[depth++] = i;
+    }
+  }
+
+  // From postorder, where the root is last, a node's last child is just
+  // before it and each child's previous sibling just before its subtree.
+  void reorder() {
+    std::vector<ParseNode> postorder;
+    postorder.swap(nodes);
+    nodes.reserve(postorder.size());
+    roots.assign(1, postorder.size() - 1);
+    while (!roots.empty()) {
+      size_t node = roots.back();
+      roots.pop_back();
+      nodes.push_back(postorder[node]);
+      size_t child = node - 1;
+      for (uint32_t n = postorder[node].children; n > 0; n--) {
+        roots.push_back(child);
+        child -= postorder[child].size;
+      }
+    }
+  }
+
+  std::vector<ParseNode> nodes;
+  // Bottom-up: the subtrees not reduced yet, left to right.
+  std::vector<size_t> roots;
+  std::vector<uint32_t> scratch;
+};
+
+#endif
@@ -0,0 +1,783 @@
+// Generated by gen_parser from the PL/0 grammar; do not edit.
+#ifndef COMPILEWORK_PL0_DESCENT_H
+#define COMPILEWORK_PL0_DESCENT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+// Recursive-descent parser for the grammar with start symbol Z.
+template <typename Input> class PL0Descent {
+public:
+  explicit PL0Descent(Input &input) : input(input) {}
+
+  // Parses input, which must be a sentence, and returns how many
+  // productions it expanded.
+  size_t parse() {
+    expansions = 0;
+    lookahead = kind();
+    parseZ();
+    if (lookahead != 1)
+      error();
+    return expansions;
+  }
+
+private:
+  int kind() {
+    return KINDS[static_cast<unsigned char>(input.peek()[0])];
+  }
+
+  void advance() {
+    input.advance();
+    lookahead = kind();
+  }
+
+  void expect(int t) {
+    if (lookahead != t)
+      error();
+    advance();
+  }
+
+  [[noreturn]] static void error() {
+    throw std::runtime_error("PredictTable wrong!\n");
+  }
+
+  void parseZ() {
+    switch (lookahead) {
+    case 2: // .
+    case 3: // c
+    case 6: // b
+    case 9: // v
+    case 10: // p
+    case 12: // s
+    case 26: // i
+    case 28: // r
+    case 29: // w
+    case 31: // y
+    case 32: // z
+      // Z --> P
+      expansions++;
+      parseP();
+      return;
+    default:
+      error();
+    }
+  }
+
+  void parseP() {
+    switch (lookahead) {
+    case 2: // .
+    case 3: // c
+    case 6: // b
+    case 9: // v
+    case 10: // p
+    case 12: // s
+    case 26: // i
+    case 28: // r
+    case 29: // w
+    case 31: // y
+    case 32: // z
+      // P --> P'.
+      expansions++;
+      parsePPrime();
+      expect(2);
+      return;
+    default:
+      error();
+    }
+  }
+
+  void parsePPrime() {
+    switch (lookahead) {
+    case 2: // .
+    case 3: // c
+    case 4: // ;
+    case 6: // b
+    case 9: // v
+    case 10: // p
+    case 12: // s
+    case 26: // i
+    case 28: // r
+    case 29: // w
+    case 31: // y
+    case 32: // z
+      // P' --> A'BI'S
+      expansions++;
+      parseAPrime();
+      parseB();
+      parseIPrime();
+      parseS();
+      return;
+    default:
+      error();
+    }
+  }
+
+  void parseAPrime() {
+    switch (lookahead) {
+    case 3: // c
+      // A' --> I
+      expansions++;
+      parseI();
+      return;
+    case 2: // .
+    case 4: // ;
+    case 6: // b
+    case 9: // v
+    case 10: // p
+    case 12: // s
+    case 26: // i
+    case 28: // r
+    case 29: // w
+    case 31: // y
+    case 32: // z
+      // A' --> ε
+      expansions++;
+      return;
+    default:
+      error();
+    }
+  }
+
+  void parseB() {
+    switch (lookahead) {
+    case 9: // v
+      // B --> V
+      expansions++;
+      parseV();
+      return;
+    case 2: // .
+    case 4: // ;
+    case 6: // b
+    case 10: // p
+    case 12: // s
+    case 26: // i
+    case 28: // r
+    case 29: // w
+    case 31: // y
+    case 32: // z
+      // B --> ε
+      expansions++;
+      return;
+    default:
+      error();
+    }
+  }
+
+  void parseI() {
+    switch (lookahead) {
+    case 3: // c
+      // I --> cDF';
+      expansions++;
+      advance();
+      parseD();
+      parseFPrime();
+      expect(4);
+      return;
+    default:
+      error();
+    }
+  }
+
+  void parseFPrime() {
+    for (;;) {
+      switch (lookahead) {
+      case 5: // ,
+        // F' --> ,DF'
+        expansions++;
+        advance();
+        parseD();
+        continue;
+      case 4: // ;
+        // F' --> ε
+        expansions++;
+        return;
+      default:
+        error();
+      }
+    }
+  }
+
+  void parseD() {
+    switch (lookahead) {
+    case 6: // b
+      // D --> b=n
+      expansions++;
+      advance();
+      expect(7);
+      expect(8);
+      return;
+    default:
+      error();
+    }
+  }
+
+  void parseV() {
+    switch (lookahead) {
+    case 9: // v
+      // V --> vbG;
+      expansions++;
+      advance();
+      expect(6);
+      parseG();
+      expect(4);
+      return;
+    default:
+      error();
+    }
+  }
+
+  void parseG() {
+    for (;;) {
+      switch (lookahead) {
+      case 5: // ,
+        // G --> ,bG
+        expansions++;
+        advance();
+        expect(6);
+        continue;
+      case 4: // ;
+        // G --> ε
+        expansions++;
+        return;
+      default:
+        error();
+      }
+    }
+  }
+
+  void parseIPrime() {
+    for (;;) {
+      switch (lookahead) {
+      case 10: // p
+        // I' --> AP';I'
+        expansions++;
+        parseA();
+        parsePPrime();
+        expect(4);
+        continue;
+      case 2: // .
+      case 4: // ;
+      case 6: // b
+      case 12: // s
+      case 26: // i
+      case 28: // r
+      case 29: // w
+      case 31: // y
+      case 32: // z
+        // I' --> ε
+        expansions++;
+        return;
+      default:
+        error();
+      }
+    }
+  }
+
+  void parseA() {
+    switch (lookahead) {
+    case 10: // p
+      // A --> pb;
+      expansions++;
+      advance();
+      expect(6);
+      expect(4);
+      return;
+    default:
+      error();
+    }
+  }
+
+  void parseS() {
+    switch (lookahead) {
+    case 6: // b
+      // S --> S'
+      expansions++;
+      parseSPrime();
+      return;
+    case 26: // i
+      // S --> C
+      expansions++;
+      parseC();
+      return;
+    case 29: // w
+      // S --> W
+      expansions++;
+      parseW();
+      return;
+    case 28: // r
+      // S --> V'
+      expansions++;
+      parseVPrime();
+      return;
+    case 31: // y
+      // S --> H
+      expansions++;
+      parseH();
+      return;
+    case 32: // z
+      // S --> D'
+      expansions++;
+      parseDPrime();
+      return;
+    case 12: // s
+      // S --> F
+      expansions++;
+      parseF();
+      return;
+    case 2: // .
+    case 4: // ;
+      // S --> E'
+      expansions++;
+      parseEPrime();
+      return;
+    default:
+      error();
+    }
+  }
+
+  void parseSPrime() {
+    switch (lookahead) {
+    case 6: // b
+      // S' --> bxE
+      expansions++;
+      advance();
+      expect(11);
+      parseE();
+      return;
+    default:
+      error();
+    }
+  }
+
+  void parseF() {
+    switch (lookahead) {
+    case 12: // s
+      // F --> sS;H'e
+      expansions++;
+      advance();
+      parseS();
+      expect(4);
+      parseHPrime();
+      expect(13);
+      return;
+    default:
+      error();
+    }
+  }
+
+  void parseHPrime() {
+    for (;;) {
+      switch (lookahead) {
+      case 4: // ;
+      case 6: // b
+      case 12: // s
+      case 26: // i
+      case 28: // r
+      case 29: // w
+      case 31: // y
+      case 32: // z
+        // H' --> S;H'
+        expansions++;
+        parseS();
+        expect(4);
+        continue;
+      case 13: // e
+        // H' --> ε
+        expansions++;
+        return;
+      default:
+        error();
+      }
+    }
+  }
+
+  void parseEPrime() {
+    switch (lookahead) {
+    case 2: // .
+    case 4: // ;
+      // E' --> ε
+      expansions++;
+      return;
+    default:
+      error();
+    }
+  }
+
+  void parseCPrime() {
+    switch (lookahead) {
+    case 6: // b
+    case 8: // n
+    case 15: // +
+    case 16: // -
+    case 17: // (
+      // C' --> ERE
+      expansions++;
+      parseE();
+      parseR();
+      parseE();
+      return;
+    case 14: // o
+      // C' --> oE
+      expansions++;
+      advance();
+      parseE();
+      return;
+    default:
+      error();
+    }
+  }
+
+  void parseE() {
+    switch (lookahead) {
+    case 6: // b
+    case 8: // n
+    case 15: // +
+    case 16: // -
+    case 17: // (
+      // E --> JTJ'
+      expansions++;
+      parseJ();
+      parseT();
+      parseJPrime();
+      return;
+    default:
+      error();
+    }
+  }
+
+  void parseJ() {
+    switch (lookahead) {
+    case 15: // +
+      // J --> +
+      expansions++;
+      advance();
+      return;
+    case 16: // -
+      // J --> -
+      expansions++;
+      advance();
+      return;
+    case 6: // b
+    case 8: // n
+    case 17: // (
+      // J --> ε
+      expansions++;
+      return;
+    default:
+      error();
+    }
+  }
+
+  void parseJPrime() {
+    for (;;) {
+      switch (lookahead) {
+      case 15: // +
+      case 16: // -
+        // J' --> LTJ'
+        expansions++;
+        parseL();
+        parseT();
+        continue;
+      case 2: // .
+      case 4: // ;
+      case 5: // ,
+      case 7: // =
+      case 18: // )
+      case 21: // ~
+      case 22: // <
+      case 23: // l
+      case 24: // g
+      case 25: // >
+      case 27: // t
+      case 30: // d
+        // J' --> ε
+        expansions++;
+        return;
+      default:
+        error();
+      }
+    }
+  }
+
+  void parseT() {
+    switch (lookahead) {
+    case 6: // b
+    case 8: // n
+    case 17: // (
+      // T --> T'K
+      expansions++;
+      parseTPrime();
+      parseK();
+      return;
+    default:
+      error();
+    }
+  }
+
+  void parseK() {
+    for (;;) {
+      switch (lookahead) {
+      case 19: // *
+      case 20: // /
+        // K --> MT'K
+        expansions++;
+        parseM();
+        parseTPrime();
+        continue;
+      case 2: // .
+      case 4: // ;
+      case 5: // ,
+      case 7: // =
+      case 15: // +
+      case 16: // -
+      case 18: // )
+      case 21: // ~
+      case 22: // <
+      case 23: // l
+      case 24: // g
+      case 25: // >
+      case 27: // t
+      case 30: // d
+        // K --> ε
+        expansions++;
+        return;
+      default:
+        error();
+      }
+    }
+  }
+
+  void parseTPrime() {
+    switch (lookahead) {
+    case 6: // b
+      // T' --> b
+      expansions++;
+      advance();
+      return;
+    case 8: // n
+      // T' --> n
+      expansions++;
+      advance();
+      return;
+    case 17: // (
+      // T' --> (E)
+      expansions++;
+      advance();
+      parseE();
+      expect(18);
+      return;
+    default:
+      error();
+    }
+  }
+
+  void parseL() {
+    switch (lookahead) {
+    case 15: // +
+      // L --> +
+      expansions++;
+      advance();
+      return;
+    case 16: // -
+      // L --> -
+      expansions++;
+      advance();
+      return;
+    default:
+      error();
+    }
+  }
+
+  void parseM() {
+    switch (lookahead) {
+    case 19: // *
+      // M --> *
+      expansions++;
+      advance();
+      return;
+    case 20: // /
+      // M --> /
+      expansions++;
+      advance();
+      return;
+    default:
+      error();
+    }
+  }
+
+  void parseR() {
+    switch (lookahead) {
+    case 21: // ~
+      // R --> ~
+      expansions++;
+      advance();
+      return;
+    case 22: // <
+      // R --> <
+      expansions++;
+      advance();
+      return;
+    case 23: // l
+      // R --> l
+      expansions++;
+      advance();
+      return;
+    case 24: // g
+      // R --> g
+      expansions++;
+      advance();
+      return;
+    case 25: // >
+      // R --> >
+      expansions++;
+      advance();
+      return;
+    case 7: // =
+      // R --> =
+      expansions++;
+      advance();
+      return;
+    default:
+      error();
+    }
+  }
+
+  void parseC() {
+    switch (lookahead) {
+    case 26: // i
+      // C --> iC'tS
+      expansions++;
+      advance();
+      parseCPrime();
+      expect(27);
+      parseS();
+      return;
+    default:
+      error();
+    }
+  }
+
+  void parseVPrime() {
+    switch (lookahead) {
+    case 28: // r
+      // V' --> rb
+      expansions++;
+      advance();
+      expect(6);
+      return;
+    default:
+      error();
+    }
+  }
+
+  void parseW() {
+    switch (lookahead) {
+    case 29: // w
+      // W --> wC'dS
+      expansions++;
+      advance();
+      parseCPrime();
+      expect(30);
+      parseS();
+      return;
+    default:
+      error();
+    }
+  }
+
+  void parseH() {
+    switch (lookahead) {
+    case 31: // y
+      // H --> y(bK')
+      expansions++;
+      advance();
+      expect(17);
+      expect(6);
+      parseKPrime();
+      expect(18);
+      return;
+    default:
+      error();
+    }
+  }
+
+  void parseKPrime() {
+    for (;;) {
+      switch (lookahead) {
+      case 5: // ,
+        // K' --> ,bK'
+        expansions++;
+        advance();
+        expect(6);
+        continue;
+      case 18: // )
+        // K' --> ε
+        expansions++;
+        return;
+      default:
+        error();
+      }
+    }
+  }
+
+  void parseMPrime() {
+    for (;;) {
+      switch (lookahead) {
+      case 5: // ,
+        // M' --> ,EM'
+        expansions++;
+        advance();
+        parseE();
+        continue;
+      case 18: // )
+        // M' --> ε
+        expansions++;
+        return;
+      default:
+        error();
+      }
+    }
+  }
+
+  void parseDPrime() {
+    switch (lookahead) {
+    case 32: // z
+      // D' --> z(EM')
+      expansions++;
+      advance();
+      expect(17);
+      parseE();
+      parseMPrime();
+      expect(18);
+      return;
+    default:
+      error();
+    }
+  }
+
+  // Terminal index of each character, or -1.
+  static constexpr int8_t KINDS[256] = {
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      -1, -1, -1, 1, -1, -1, -1, -1, 17, 18, 19, 15, 5, 16, 2, 20,
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 4, 22, 7, 25, -1,
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      -1, -1, 6, 3, 30, 13, -1, 24, -1, 26, -1, -1, 23, -1, 8, 14,
+      10, -1, 28, 12, 27, -1, 9, 29, 11, 31, 32, -1, -1, -1, 21, -1,
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1};
+
+  Input &input;
+  int lookahead;
+  size_t expansions;
+};
+
+#endif
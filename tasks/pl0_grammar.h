@@ -0,0 +1,286 @@
+#ifndef COMPILEWORK_PL0_GRAMMAR_H
+#define COMPILEWORK_PL0_GRAMMAR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "grammar.h"
+
+// A production in the one-character notation of splitProduction(): lhs is
+// an uppercase letter, optionally followed by ', and rhs is its symbols run
+// together, or Epsilon.
+struct StaticProduction {
+  const char *lhs, *rhs;
+};
+
+// A grammar written as N StaticProductions and analysed while compiling:
+// nullable, FIRST, FOLLOW and SELECT as terminal bitmasks, then the LL(1)
+// predict table laid out as PredictCells reads it. The productions of a
+// nonterminal are listed together and the first one's lhs is the start
+// symbol. Symbols and productions are numbered as Grammar numbers them when
+// buildGrammar() is given the same list, so the table indexes that Grammar
+// directly. An undefined nonterminal, a grammar that is not LL(1) or one
+// with too many terminals throws, which during constant evaluation stops
+// the build.
+template <size_t N> class StaticGrammar {
+public:
+  // Terminal sets are single words, and the first two terminals are Epsilon
+  // and "#" as in SymbolTable.
+  static constexpr size_t MAX_TERMINALS = 64, MAX_RHS = 8;
+
+  constexpr explicit StaticGrammar(const StaticProduction (&productions)[N]) {
+    for (int &n : nonterminal_of)
+      n = -1;
+    for (int &t : terminal_of)
+      t = -1;
+    terminal_of['#'] = 1;
+    terminals = 2;
+    for (size_t r = 0; r < N; r++) {
+      rules[r] = productions[r];
+      int key = nonterminalKey(productions[r].lhs);
+      if (nonterminal_of[key] < 0)
+        nonterminal_of[key] = nonterminals++;
+      else if (nonterminal_of[key] != lhs[r - 1])
+        throw std::runtime_error("Productions of a nonterminal are apart");
+      lhs[r] = nonterminal_of[key];
+    }
+    for (size_t r = 0; r < N; r++)
+      split(r);
+    analyse();
+    for (int &cell : cells)
+      cell = NO_RULE;
+    for (size_t r = 0; r < N; r++) {
+      for (size_t t = 0; t < terminals; t++) {
+        if (!(select[r] >> t & 1))
+          continue;
+        int32_t &cell = cells[lhs[r] * terminals + t];
+        if (cell != NO_RULE)
+          throw std::runtime_error("Not LL(1) Grammar");
+        cell = r;
+      }
+    }
+  }
+
+  constexpr size_t nonterminalCount() const { return nonterminals; }
+  constexpr size_t terminalCount() const { return terminals; }
+  constexpr size_t productionCount() const { return N; }
+  constexpr const StaticProduction &production(size_t rule) const {
+    return rules[rule];
+  }
+  // Rule for nonterminal index n on terminal index t at [n * terminalCount()
+  // + t], or NO_RULE.
+  constexpr const int32_t *predictCells() const { return cells; }
+
+private:
+  static constexpr bool isUpper(char c) { return c >= 'A' && c <= 'Z'; }
+
+  static constexpr int nonterminalKey(char c, bool primed) {
+    return (c - 'A') * 2 + primed;
+  }
+
+  static constexpr int nonterminalKey(const char *name) {
+    if (!isUpper(name[0]) ||
+        (name[1] != 0 && (name[1] != '\'' || name[2] != 0)))
+      throw std::runtime_error("Bad nonterminal name");
+    return nonterminalKey(name[0], name[1] == '\'');
+  }
+
+  // Right-hand sides hold a nonterminal index n as n and a terminal index t
+  // as ~t. Terminals are numbered as they are first seen.
+  constexpr void split(size_t r) {
+    const char *text = rules[r].rhs;
+    if (text[0] == Epsilon[0] && text[1] == 0)
+      return;
+    for (size_t i = 0; text[i] != 0; i++) {
+      if (length[r] == MAX_RHS)
+        throw std::runtime_error("Production too long");
+      unsigned char c = text[i];
+      if (isUpper(c)) {
+        bool primed = text[i + 1] == '\'';
+        int n = nonterminal_of[nonterminalKey(c, primed)];
+        if (n < 0)
+          throw std::runtime_error("Undefined nonterminal");
+        rhs[r][length[r]++] = n;
+        i += primed;
+        continue;
+      }
+      if (c == Epsilon[0] || c == '\'' || c == '#')
+        throw std::runtime_error("Bad terminal");
+      if (terminal_of[c] < 0) {
+        if (terminals == MAX_TERMINALS)
+          throw std::runtime_error("Too many terminals");
+        terminal_of[c] = terminals++;
+      }
+      rhs[r][length[r]++] = ~terminal_of[c];
+    }
+  }
+
+  constexpr void analyse() {
+    for (bool changed = true; changed;) {
+      changed = false;
+      for (size_t r = 0; r < N; r++) {
+        bool empty = true;
+        for (size_t i = 0; i < length[r] && empty; i++)
+          empty = rhs[r][i] >= 0 && nullable[rhs[r][i]];
+        if (empty && !nullable[lhs[r]])
+          nullable[lhs[r]] = changed = true;
+      }
+    }
+    for (bool changed = true; changed;) {
+      changed = false;
+      for (size_t r = 0; r < N; r++) {
+        uint64_t set = first[lhs[r]] | prefix(r, 0);
+        changed |= set != first[lhs[r]];
+        first[lhs[r]] = set;
+      }
+    }
+    follow[0] = uint64_t(1) << SymbolTable::END;
+    for (bool changed = true; changed;) {
+      changed = false;
+      for (size_t r = 0; r < N; r++) {
+        // What can follow the symbols from i on.
+        uint64_t after = follow[lhs[r]];
+        for (size_t i = length[r]; i-- > 0;) {
+          int s = rhs[r][i];
+          if (s < 0) {
+            after = uint64_t(1) << ~s;
+            continue;
+          }
+          changed |= (follow[s] | after) != follow[s];
+          follow[s] |= after;
+          after = nullable[s] ? after | first[s] : first[s];
+        }
+      }
+    }
+    for (size_t r = 0; r < N; r++) {
+      select[r] = prefix(r, 0);
+      bool empty = true;
+      for (size_t i = 0; i < length[r] && empty; i++)
+        empty = rhs[r][i] >= 0 && nullable[rhs[r][i]];
+      if (empty)
+        select[r] |= follow[lhs[r]];
+    }
+  }
+
+  // FIRST of the symbols of production r from i on, without Epsilon.
+  constexpr uint64_t prefix(size_t r, size_t i) const {
+    uint64_t set = 0;
+    for (; i < length[r]; i++) {
+      int s = rhs[r][i];
+      if (s < 0)
+        return set | uint64_t(1) << ~s;
+      set |= first[s];
+      if (!nullable[s])
+        break;
+    }
+    return set;
+  }
+
+  StaticProduction rules[N] = {};
+  int nonterminal_of[52] = {}, terminal_of[256] = {};
+  size_t nonterminals = 0, terminals = 0;
+  int lhs[N] = {}, rhs[N][MAX_RHS] = {};
+  size_t length[N] = {};
+  // By nonterminal index; there are at most N nonterminals.
+  bool nullable[N] = {};
+  uint64_t first[N] = {}, follow[N] = {}, select[N] = {};
+  int32_t cells[N * MAX_TERMINALS] = {};
+};
+
+// Builds the Grammar that grammar's predict table indexes.
+template <size_t N>
+inline Grammar *buildGrammar(const StaticGrammar<N> &grammar) {
+  std::vector<Nonterminal *> targets;
+  std::unordered_map<std::string, Terminal *> terms;
+  for (size_t r = 0; r < N; r++) {
+    const StaticProduction &p = grammar.production(r);
+    if (targets.empty() || targets.back()->name != p.lhs)
+      targets.push_back(new Nonterminal(p.lhs));
+    for (const char *c = p.rhs; *c != 0; c++) {
+      if (!isNonterminal(*c))
+        terms[{*c}] = new Terminal({*c});
+    }
+    targets.back()->addProduction(p.rhs);
+  }
+  auto g = new Grammar(grammar.production(0).lhs, targets, terms);
+  for (auto node : targets)
+    delete node;
+  return g;
+}
+
+// The PL/0 grammar over encodeTerminal()'s single-character terminals.
+constexpr StaticProduction PL0_PRODUCTIONS[] = {
+    {"Z", "P"},
+    {"P", "P'."},
+    {"P'", "A'BI'S"},
+    {"A'", "I"},
+    {"A'", Epsilon},
+    {"B", "V"},
+    {"B", Epsilon},
+    {"I", "cDF';"},
+    {"F'", ",DF'"},
+    {"F'", Epsilon},
+    {"D", "b=n"},
+    {"V", "vbG;"},
+    {"G", ",bG"},
+    {"G", Epsilon},
+    {"I'", "AP';I'"},
+    {"I'", Epsilon},
+    {"A", "pb;"},
+    {"S", "S'"},
+    {"S", "C"},
+    {"S", "W"},
+    {"S", "V'"},
+    {"S", "H"},
+    {"S", "D'"},
+    {"S", "F"},
+    {"S", "E'"},
+    {"S'", "bxE"},
+    {"F", "sS;H'e"},
+    {"H'", "S;H'"},
+    {"H'", Epsilon},
+    {"E'", Epsilon},
+    {"C'", "ERE"},
+    {"C'", "oE"},
+    {"E", "JTJ'"},
+    {"J", "+"},
+    {"J", "-"},
+    {"J", Epsilon},
+    {"J'", "LTJ'"},
+    {"J'", Epsilon},
+    {"T", "T'K"},
+    {"K", "MT'K"},
+    {"K", Epsilon},
+    {"T'", "b"},
+    {"T'", "n"},
+    {"T'", "(E)"},
+    {"L", "+"},
+    {"L", "-"},
+    {"M", "*"},
+    {"M", "/"},
+    {"R", "~"},
+    {"R", "<"},
+    {"R", "l"},
+    {"R", "g"},
+    {"R", ">"},
+    {"R", "="},
+    {"C", "iC'tS"},
+    {"V'", "rb"},
+    {"W", "wC'dS"},
+    {"H", "y(bK')"},
+    {"K'", ",bK'"},
+    {"K'", Epsilon},
+    {"M'", ",EM'"},
+    {"M'", Epsilon},
+    {"D'", "z(EM')"}};
+
+// Its predict table, worked out by the compiler.
+inline constexpr StaticGrammar PL0_GRAMMAR(PL0_PRODUCTIONS);
+
+inline Grammar *getGrammer() { return buildGrammar(PL0_GRAMMAR); }
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef COMPILEWORK_PREDICT_TABLE_H
+#define COMPILEWORK_PREDICT_TABLE_H
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "expression_parser.h"
+#include "grammar.h"
+#include "ll1_driver.h"
+#include "parse_tree.h"
+#include "pl0_grammar.h"
+#include "quadruple.h"
+#include "table_image.h"
+#include "token_source.h"
+
+class PredictTable {
+public:
+  PredictTable(Grammar &G) : grammar(G), driver(grammar, PredictCells(G)) {}
+  // Uses the table the compiler worked out for source; G must have been
+  // built from it.
+  template <size_t N>
+  PredictTable(Grammar &G, const StaticGrammar<N> &source)
+      : grammar(G),
+        driver(grammar,
+               PredictCells(source.predictCells(), source.terminalCount())) {}
+  // Reads the grammar and table from a prebuilt image instead.
+  PredictTable(TableImage image)
+      : grammar(image.grammar()),
+        driver(grammar, PredictCells(std::move(image))) {}
+
+  void clear_stack() { driver.clear(); }
+
+  void setInputs(const std::string &str) { inputs = StringInput(str); }
+
+  // In expression mode every expression is handed to ExpressionParser
+  // rather than expanded on the stack, and its quadruples are kept.
+  void setExpressionMode(bool on) {
+    const SymbolTable &symbols = grammar.getSymbols();
+    Symbol e = symbols.find(EXPRESSION_NONTERMINAL);
+    if (on && (e == NO_SYMBOL || !symbols.isNonterminal(e)))
+      throw std::runtime_error("No expressions in this grammar");
+    driver.delegate(on ? symbols.index(e) : LL1Driver::NO_ROW);
+  }
+
+  // What the expressions of the last analysis in expression mode compute.
+  const std::vector<Quadruple> &quadruples() const { return codes; }
+
+  // Builds the parse tree of each analysis into tree, or none if it is
+  // null. Terminals refer to their tokens by input position.
+  void buildTree(ParseTree *tree) { driver.build(tree); }
+
+  const SymbolTable &getSymbols() const { return grammar.getSymbols(); }
+
+  void diplayTable() {
+    const SymbolTable &symbols = grammar.getSymbols();
+    auto &terminals = symbols.terminals();
+    printSeperater(terminals.size());
+    std::cout << "PredictTable:\n";
+    printSeperater(terminals.size());
+    std::cout << '\t';
+    for (Symbol t : terminals) {
+      if (t != SymbolTable::EPSILON)
+        std::cout << symbols.name(t) << "\t";
+    }
+    for (Symbol non : symbols.nonterminals()) {
+      std::cout << '\n' << symbols.name(non) << "\t";
+      for (Symbol t : terminals) {
+        if (t == SymbolTable::EPSILON)
+          continue;
+        int rule = driver.rule(symbols.index(non), symbols.index(t));
+        if (rule != NO_RULE)
+          std::cout << ToEpsilon(grammar.getProductionText(rule));
+        std::cout << "\t";
+      }
+    }
+    std::cout << '\n';
+  }
+
+  std::vector<int> analysis(bool verbose) { return analysis(inputs, verbose); }
+
+  // Productions the last analysis expanded, i.e. its derivation steps.
+  size_t expansionCount() const { return expansions; }
+
+  // Parses input through in one pass, recovering from syntax errors in
+  // panic mode, and returns the lines with errors; none means input is a
+  // sentence.
+  template <typename Input>
+  std::vector<int> analysis(Input &input, bool verbose) {
+    std::vector<int> errors;
+    codes.clear();
+    ExpressionParser<Input> expressions(input, codes);
+    std::string place;
+    bool parsed = false;
+    auto error = [&errors](Input &at) {
+      if (errors.empty() || errors.back() != at.line())
+        errors.push_back(at.line());
+    };
+    auto other = [&](Input &) { return parsed = expressions.parse(place); };
+    if (!verbose) {
+      expansions = driver.parse(input, error, other);
+      return errors;
+    }
+    const SymbolTable &symbols = grammar.getSymbols();
+    expansions = 0;
+    driver.begin(input);
+    printSeperater(6);
+    std::cout << "步骤" << '\t' << "分析栈"
+              << "\t\t"
+              << "输入缓存区" << '\t' << "动作" << std::endl;
+    printSeperater(6);
+    for (int step = 1;; step++) {
+      std::cout << step << '\t';
+      for (size_t i = 0; i < driver.depth(); i++)
+        std::cout << symbols.name(driver.symbolAt(i));
+      std::cout << "\t\t";
+      input.print();
+      std::cout << "\t\t";
+      const std::string &top =
+          symbols.name(driver.symbolAt(driver.depth() - 1));
+      std::string lookahead = input.peek();
+      size_t first = codes.size();
+      int rule;
+      LL1Driver::Action action = driver.next(input, error, other, rule);
+      if (action == LL1Driver::EXPAND) {
+        expansions++;
+        std::cout << top << " --> " << grammar.getProductionText(rule)
+                  << "\t\n";
+      } else if (action == LL1Driver::MATCH) {
+        std::cout << "匹配" + top << "\t\n";
+      } else if (action == LL1Driver::DELEGATE) {
+        std::cout << (parsed ? top + " ==> " + place : "出错,表达式");
+        for (size_t i = first; i < codes.size(); i++)
+          std::cout << "(" << codes[i].first << "," << codes[i].second << ","
+                    << codes[i].third << "," << codes[i].fourth << ")";
+        std::cout << "\t\n";
+      } else if (action == LL1Driver::ACCEPT) {
+        std::cout << "Accpet"
+                  << "\t\n";
+        break;
+      } else if (action == LL1Driver::POP) {
+        std::cout << "出错,弹出" + top << "\t\n";
+      } else {
+        std::cout << "出错,跳过" + lookahead << "\t\n";
+      }
+    }
+    return errors;
+  }
+
+private:
+  Grammar grammar;
+  LL1Driver driver;
+  StringInput inputs;
+  size_t expansions = 0;
+  std::vector<Quadruple> codes;
+};
+
+#endif
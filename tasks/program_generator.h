@@ -0,0 +1,343 @@
+#ifndef COMPILEWORK_PROGRAM_GENERATOR_H
+#define COMPILEWORK_PROGRAM_GENERATOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "lexer.h"
+
+// Knobs for ProgramGenerator. Probabilities are in [0, 1].
+struct GeneratorOptions {
+  // Approximate length of the program in bytes.
+  size_t size = 1 << 20;
+  uint64_t seed = 1;
+  // Chance of a comment before each declaration block and statement.
+  double comment_density = 0.05;
+  // Identifier lengths are drawn uniformly from this range. Names only run
+  // longer when the range is too short to keep them unique.
+  int min_ident_len = 1, max_ident_len = 6;
+  // Deepest procedure, statement and parenthesised expression nesting.
+  int procedure_depth = 3, statement_depth = 4, expression_depth = 4;
+};
+
+// Writes random PL/0 programs that getGrammer() accepts and that task3
+// translates without semantic errors: every name is declared before it is
+// used, variables are never declared twice, and calls, reads and
+// assignments only name procedures and variables that are in scope.
+//
+// Output is streamed and only the enclosing scopes are kept, so programs of
+// any size are generated in bounded memory.
+class ProgramGenerator {
+public:
+  ProgramGenerator(const GeneratorOptions &options)
+      : options(options), rng(options.seed), names(0), flushed(0),
+        out(nullptr) {
+    if (options.min_ident_len < 1 ||
+        options.min_ident_len > options.max_ident_len ||
+        options.max_ident_len > MAX_IDENT_LEN)
+      throw std::runtime_error("Identifier lengths must be within 1.." +
+                               std::to_string(MAX_IDENT_LEN));
+    if (options.comment_density < 0 || options.comment_density > 1)
+      throw std::runtime_error("Comment density must be within 0..1");
+    if (options.procedure_depth < 0 || options.statement_depth < 1 ||
+        options.expression_depth < 0)
+      throw std::runtime_error("Nesting depths must not be negative");
+  }
+
+  void generate(std::ostream &os) {
+    out = &os;
+    flushed = 0;
+    text.clear();
+    scopes.clear();
+    // Procedures take the first three quarters of the budget and the main
+    // block the rest.
+    enterScope();
+    declarations(0, 2);
+    while (written() < proceduresLimit())
+      procedure(0);
+    compound(0, 0, options.size);
+    text += ".\n";
+    scopes.pop_back();
+    flush();
+    out = nullptr;
+  }
+
+  std::string generate() {
+    std::ostringstream os;
+    generate(os);
+    return os.str();
+  }
+
+private:
+  // Names a scope may use. Only the most recent procedures are kept, which
+  // bounds memory without changing what the program exercises.
+  struct Scope {
+    std::vector<std::string> consts, vars, procedures;
+  };
+  static constexpr size_t MAX_PROCEDURES_KEPT = 32;
+  static constexpr size_t FLUSH_BYTES = 1 << 16;
+
+  size_t written() const { return flushed + text.size(); }
+  size_t proceduresLimit() const { return options.size / 4 * 3; }
+
+  void flush() {
+    out->write(text.data(), text.size());
+    flushed += text.size();
+    text.clear();
+  }
+
+  void emit(const std::string &s) {
+    text += s;
+    if (text.size() >= FLUSH_BYTES)
+      flush();
+  }
+
+  uint64_t below(uint64_t n) { return rng() % n; }
+  bool chance(double p) {
+    return std::generate_canonical<double, 64>(rng) < p;
+  }
+  template <typename T> const T &pick(const std::vector<T> &v) {
+    return v[below(v.size())];
+  }
+
+  static std::string indent(int level) { return std::string(2 * level, ' '); }
+
+  // The counter is spelt in bijective base 26, which keeps names unique and
+  // short, and padded with digits up to the drawn length. A bare letter run
+  // can spell a reserved word, so those get a digit too.
+  std::string identifier() {
+    std::string name;
+    for (uint64_t n = ++names; n > 0; n = (n - 1) / 26)
+      name.insert(name.begin(), char('a' + (n - 1) % 26));
+    size_t len = options.min_ident_len +
+                 below(options.max_ident_len - options.min_ident_len + 1);
+    while (name.size() < len)
+      name += char('0' + below(10));
+    if (isReservedWord(name))
+      name += '0';
+    return name;
+  }
+
+  std::string number() {
+    std::string n(1, char('1' + below(9)));
+    for (uint64_t digits = below(5); digits > 0; digits--)
+      n += char('0' + below(10));
+    return n;
+  }
+
+  void enterScope() { scopes.emplace_back(); }
+
+  void comment(int level) {
+    static const char *words[] = {"update", "the", "running", "total",
+                                  "check",  "loop", "bounds", "keep",
+                                  "state",  "for",  "next",   "pass"};
+    std::string body;
+    for (uint64_t n = 2 + below(6); n > 0; n--) {
+      body += ' ';
+      body += words[below(sizeof(words) / sizeof(*words))];
+    }
+    if (chance(0.5))
+      emit(indent(level) + "//" + body + "\n");
+    else
+      emit(indent(level) + "/*" + body + " */\n");
+  }
+
+  void maybeComment(int level) {
+    if (chance(options.comment_density))
+      comment(level);
+  }
+
+  // const and var blocks of the current scope; at least min_vars variables.
+  void declarations(int level, int min_vars) {
+    Scope &scope = scopes.back();
+    if (chance(0.6)) {
+      maybeComment(level);
+      std::string line = indent(level) + "const ";
+      for (uint64_t n = 1 + below(3); n > 0; n--) {
+        scope.consts.push_back(identifier());
+        line += scope.consts.back() + " = " + number() + (n > 1 ? ", " : ";\n");
+      }
+      emit(line);
+    }
+    uint64_t vars = min_vars + below(4);
+    if (vars > 0) {
+      maybeComment(level);
+      std::string line = indent(level) + "var ";
+      for (uint64_t n = vars; n > 0; n--) {
+        scope.vars.push_back(identifier());
+        line += scope.vars.back() + (n > 1 ? ", " : ";\n");
+      }
+      emit(line);
+    }
+  }
+
+  void procedure(int level) {
+    std::string name = identifier();
+    auto &procedures = scopes.back().procedures;
+    if (procedures.size() == MAX_PROCEDURES_KEPT)
+      procedures.erase(procedures.begin());
+    procedures.push_back(name);
+    maybeComment(level);
+    emit(indent(level) + "procedure " + name + ";\n");
+    enterScope();
+    declarations(level + 1, 0);
+    if (level < options.procedure_depth) {
+      for (uint64_t n = below(3); n > 0 && written() < proceduresLimit(); n--)
+        procedure(level + 1);
+    }
+    // Bodies are small against large targets and shrink to fit small ones.
+    size_t budget = written() + std::min<size_t>(options.size / 8 + 64, 4096);
+    emit(indent(level + 1));
+    compound(level + 1, 0, budget);
+    emit(";\n");
+    scopes.pop_back();
+  }
+
+  // begin ... end, starting at the current column; statements are added until
+  // limit bytes have been written.
+  void compound(int level, int depth, size_t limit) {
+    emit("begin\n");
+    do {
+      maybeComment(level + 1);
+      emit(indent(level + 1));
+      statement(level + 1, depth);
+      emit(";\n");
+    } while (written() < limit);
+    emit(indent(level) + "end");
+  }
+
+  void statement(int level, int depth) {
+    bool nest = depth < options.statement_depth;
+    switch (below(nest ? 8 : 5)) {
+    case 0:
+    case 1:
+      emit(variable() + " := " + expression(options.expression_depth));
+      break;
+    case 2:
+      if (const std::string *proc = procedureInScope()) {
+        emit("call " + *proc);
+        break;
+      }
+      emit(variable() + " := " + expression(options.expression_depth));
+      break;
+    case 3: {
+      std::string line = "read(" + variable();
+      for (uint64_t n = below(3); n > 0; n--)
+        line += ", " + variable();
+      emit(line + ")");
+      break;
+    }
+    case 4:
+      emit(writeStatement());
+      break;
+    case 5:
+      emit("if " + condition() + " then\n" + indent(level + 1));
+      statement(level + 1, depth + 1);
+      break;
+    case 6:
+      emit("while " + condition() + " do\n" + indent(level + 1));
+      statement(level + 1, depth + 1);
+      break;
+    default:
+      compound(level, depth + 1, written() + 64 + below(256));
+      break;
+    }
+  }
+
+  // task3 looks up the operand after a leading binary operator in write(...)
+  // as a symbol, and only the first name of a const list ever is one, so that
+  // operand is always a variable.
+  std::string writeStatement() {
+    std::string line = "write(" + operand();
+    if (chance(0.5)) {
+      line += std::string(" ") + "+-*/"[below(4)] + " " + variable();
+      if (chance(0.5))
+        line += std::string(" ") + "+-"[below(2)] + " " +
+                term(options.expression_depth);
+    }
+    for (uint64_t n = below(3); n > 0; n--)
+      line += ", " + expression(options.expression_depth);
+    return line + ")";
+  }
+
+  std::string condition() {
+    static const char *relations[] = {"=", "#", "<", "<=", ">", ">="};
+    if (below(6) == 0)
+      return "odd " + expression(options.expression_depth);
+    return expression(options.expression_depth) + " " + relations[below(6)] +
+           " " + expression(options.expression_depth);
+  }
+
+  std::string expression(int depth) {
+    std::string e;
+    if (below(10) == 0)
+      e += "+-"[below(2)];
+    e += term(depth);
+    for (uint64_t n = below(3); n > 0; n--)
+      e += std::string(" ") + "+-"[below(2)] + " " + term(depth);
+    return e;
+  }
+
+  std::string term(int depth) {
+    std::string t = factor(depth);
+    for (uint64_t n = below(2); n > 0; n--)
+      t += std::string(" ") + "*/"[below(2)] + " " + factor(depth);
+    return t;
+  }
+
+  std::string factor(int depth) {
+    uint64_t kind = below(depth > 0 ? 10 : 9);
+    if (kind < 6)
+      return operand();
+    if (kind < 9)
+      return number();
+    return "(" + expression(depth - 1) + ")";
+  }
+
+  // A constant or variable visible from the current scope.
+  std::string operand() {
+    if (below(4) == 0) {
+      if (const std::string *c = nameInScope(&Scope::consts))
+        return *c;
+    }
+    return variable();
+  }
+
+  std::string variable() { return *nameInScope(&Scope::vars); }
+
+  const std::string *procedureInScope() {
+    return nameInScope(&Scope::procedures);
+  }
+
+  // A random name of the given kind, from the innermost scope or, less
+  // often, an enclosing one. The global scope always declares variables.
+  const std::string *nameInScope(std::vector<std::string> Scope::*kind) {
+    for (size_t i = scopes.size(); i-- > 0;) {
+      const auto &list = scopes[i].*kind;
+      if (!list.empty() && (i == 0 || chance(0.7)))
+        return &pick(list);
+    }
+    for (size_t i = scopes.size(); i-- > 0;) {
+      if (!(scopes[i].*kind).empty())
+        return &pick(scopes[i].*kind);
+    }
+    return nullptr;
+  }
+
+  GeneratorOptions options;
+  std::mt19937_64 rng;
+  uint64_t names;
+  std::vector<Scope> scopes;
+  std::string text;
+  size_t flushed;
+  std::ostream *out;
+};
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef COMPILEWORK_QUADRUPLE_H
+#define COMPILEWORK_QUADRUPLE_H
+
+#include <string>
+#include <utility>
+
+// An intermediate code instruction: operator, two operands and the result,
+// "_" where there is none.
+struct Quadruple {
+  std::string first, second, third, fourth;
+
+  Quadruple(std::string a, std::string b, std::string c, std::string d)
+      : first(std::move(a)), second(std::move(b)), third(std::move(c)),
+        fourth(std::move(d)) {}
+};
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef COMPILEWORK_SIMD_SCAN_H
+#define COMPILEWORK_SIMD_SCAN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Bulk scanners for the parts of a source that are skipped: runs of blanks,
+// block comment bodies and line comment bodies. They scan 32 bytes at a time
+// with AVX2 (build with -mavx2), 16 with SSE2, and fall back to plain loops
+// elsewhere. Every function works on src[pos, end) and reports the newlines it
+// skips so the caller's line counter stays exact.
+namespace simdscan {
+
+inline bool isBlank(char ch) {
+  return ch == ' ' || (ch >= '\t' && ch <= '\r');
+}
+
+#if defined(__AVX2__)
+constexpr size_t WIDTH = 32;
+using Vec = __m256i;
+inline Vec load(const char *p) {
+  return _mm256_loadu_si256(reinterpret_cast<const Vec *>(p));
+}
+inline uint32_t matches(Vec v, char ch) {
+  return _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(ch)));
+}
+// Blanks are ' ' and '\t'..'\r'; bytes >= 0x80 compare as negative and are
+// never blank.
+inline uint32_t blanks(Vec v) {
+  Vec range = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(8)),
+                               _mm256_cmpgt_epi8(_mm256_set1_epi8(14), v));
+  return _mm256_movemask_epi8(range) | matches(v, ' ');
+}
+#elif defined(__SSE2__)
+constexpr size_t WIDTH = 16;
+using Vec = __m128i;
+inline Vec load(const char *p) {
+  return _mm_loadu_si128(reinterpret_cast<const Vec *>(p));
+}
+inline uint32_t matches(Vec v, char ch) {
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(ch)));
+}
+inline uint32_t blanks(Vec v) {
+  Vec range = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(8)),
+                            _mm_cmplt_epi8(v, _mm_set1_epi8(14)));
+  return _mm_movemask_epi8(range) | matches(v, ' ');
+}
+#else
+constexpr size_t WIDTH = 0;
+#endif
+
+inline uint32_t lowBits(int n) { return n >= 32 ? ~0u : (1u << n) - 1; }
+
+// Returns the first non-blank position at or after pos.
+inline size_t skipBlanks(const char *src, size_t pos, size_t end, int &line) {
+  if (pos < end && !isBlank(src[pos]))
+    return pos;
+#if defined(__AVX2__) || defined(__SSE2__)
+  uint32_t full = lowBits(WIDTH);
+  while (pos + WIDTH <= end) {
+    Vec v = load(src + pos);
+    uint32_t stop = ~blanks(v) & full;
+    uint32_t newlines = matches(v, '\n');
+    if (stop) {
+      int i = __builtin_ctz(stop);
+      line += __builtin_popcount(newlines & lowBits(i));
+      return pos + i;
+    }
+    line += __builtin_popcount(newlines);
+    pos += WIDTH;
+  }
+#endif
+  while (pos < end && isBlank(src[pos])) {
+    line += src[pos] == '\n';
+    pos++;
+  }
+  return pos;
+}
+
+// Returns the position of the '*' of the first "*/" at or after pos. A '*' in
+// the last byte may be the first half of a "*/" cut off by the end of a
+// window, so it is returned too; end means no close was seen.
+inline size_t findCommentClose(const char *src, size_t pos, size_t end,
+                               int &line) {
+#if defined(__AVX2__) || defined(__SSE2__)
+  while (pos + WIDTH + 1 <= end) {
+    Vec v = load(src + pos);
+    uint32_t close = matches(v, '*') & matches(load(src + pos + 1), '/');
+    uint32_t newlines = matches(v, '\n');
+    if (close) {
+      int i = __builtin_ctz(close);
+      line += __builtin_popcount(newlines & lowBits(i));
+      return pos + i;
+    }
+    line += __builtin_popcount(newlines);
+    pos += WIDTH;
+  }
+#endif
+  while (pos < end) {
+    if (src[pos] == '*' && (pos + 1 == end || src[pos + 1] == '/'))
+      return pos;
+    line += src[pos] == '\n';
+    pos++;
+  }
+  return end;
+}
+
+// Returns the position of the next '\n' at or after pos, or end. glibc's
+// memchr is already vectorised, so it serves every target.
+inline size_t findNewline(const char *src, size_t pos, size_t end) {
+  if (pos >= end)
+    return end;
+  const void *nl = std::memchr(src + pos, '\n', end - pos);
+  return nl ? static_cast<const char *>(nl) - src : end;
+}
+
+} // namespace simdscan
+
+#endif
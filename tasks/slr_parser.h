@@ -0,0 +1,411 @@
+#ifndef COMPILEWORK_SLR_PARSER_H
+#define COMPILEWORK_SLR_PARSER_H
+
+#include <algorithm>
+#include <iostream>
+#include <set>
+#include <stack>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "grammar.h"
+#include "parse_tree.h"
+#include "token_source.h"
+
+// An LR(0) item: production rule with the dot before symbol dot of its
+// right-hand side. next is that symbol, or NO_SYMBOL once the dot is at the
+// end.
+class Item {
+public:
+  int rule, dot;
+  Symbol next;
+  Item(const Grammar &G, int rule, int dot) : rule(rule), dot(dot) {
+    if (rule < 0 || size_t(rule) >= G.productionCount())
+      throw std::runtime_error("[ITEM]: Production Index Error");
+    SymbolSpan rhs = G.getRhs(rule);
+    if (dot < 0 || size_t(dot) > rhs.size())
+      throw std::runtime_error("[ITEM]: String Index Error");
+    next = size_t(dot) < rhs.size() ? rhs[dot] : NO_SYMBOL;
+  };
+
+  Item toNext(const Grammar &G) const {
+    if (next == NO_SYMBOL)
+      throw std::runtime_error("toNext Wrong!");
+    return Item(G, rule, dot + 1);
+  }
+
+  std::string getProduction(const Grammar &G) const {
+    const SymbolTable &symbols = G.getSymbols();
+    SymbolSpan rhs = G.getRhs(rule);
+    std::string prods = symbols.name(G.getProduction(rule).lhs) + " --> ";
+    for (size_t i = 0; i < rhs.size(); i++) {
+      if (i == size_t(dot))
+        prods += "・";
+      prods += symbols.name(rhs[i]);
+    }
+    if (size_t(dot) == rhs.size()) {
+      prods += "・";
+    }
+    return prods;
+  }
+
+  bool operator==(const Item &other) const {
+    return rule == other.rule && dot == other.dot;
+  }
+
+  size_t hash() const {
+    size_t h1 = std::hash<int>{}(rule);
+    size_t h2 = std::hash<int>{}(dot);
+    return h1 ^ (h2 << 1);
+  }
+};
+
+class ItemHash {
+public:
+  size_t operator()(const Item &item) const { return item.hash(); }
+};
+
+class ItemSet : public std::vector<Item> {
+public:
+  ItemSet(){};
+
+  void push_back(const Item &item) {
+    if (item.next == NO_SYMBOL) {
+      hasReduce = true;
+    } else {
+      hasShift = true;
+    }
+    auto it = std::find_if(nextItems.begin(), nextItems.end(),
+                           [&](const auto &n) { return n.first == item.next; });
+    if (it == nextItems.end())
+      nextItems.push_back({item.next, {size()}});
+    else
+      it->second.push_back(size());
+    std::vector<Item>::push_back(item);
+  }
+
+  // Items by the symbol after their dot, in order of first appearance.
+  const std::vector<std::pair<Symbol, std::vector<size_t>>> &
+  getNexts() const {
+    return nextItems;
+  }
+
+  bool hasConflict() { return hasShift && hasReduce; }
+
+  bool operator==(const ItemSet &other) const {
+    if (size() != other.size())
+      return false;
+    for (const auto &i : other) {
+      if (std::find(begin(), end(), i) == end())
+        return false;
+    }
+    return true;
+  }
+
+private:
+  std::vector<std::pair<Symbol, std::vector<size_t>>> nextItems;
+  bool hasShift = false, hasReduce = false;
+};
+
+enum ActionKind { SHIFT, REDUCE, ACCEPT };
+
+// target is the next state for SHIFT and the production for REDUCE.
+struct Action {
+  ActionKind kind;
+  int target;
+};
+
+class SLRParser {
+public:
+  using ActionTable = std::vector<std::unordered_map<Symbol, Action>>;
+  using GotoTable = std::vector<std::unordered_map<Symbol, int>>;
+
+  // Builds the item sets and tables, printing each item set when trace.
+  SLRParser(Grammar *G, bool trace = true)
+      : trace(trace), global_idx(0), grammar(G) {
+    buildItemSets();
+    ter.insert(SymbolTable::END);
+  };
+
+  // Takes tables built earlier, e.g. from a TableImage; G must be the
+  // grammar they were built for. There are no item sets to show.
+  SLRParser(Grammar *G, ActionTable actions, GotoTable gotos)
+      : ACTIONs(std::move(actions)), GOTOs(std::move(gotos)), trace(false),
+        global_idx(0), grammar(G) {
+    // As buildItemSets() does, show the terminals that are shifted.
+    ter.insert(SymbolTable::END);
+    for (const auto &line : ACTIONs) {
+      for (const auto &entry : line) {
+        if (entry.second.kind == SHIFT)
+          ter.insert(entry.first);
+      }
+    }
+    for (const auto &line : GOTOs) {
+      for (const auto &entry : line)
+        non.insert(entry.first);
+    }
+  }
+
+  const ActionTable &getACTIONs() const { return ACTIONs; }
+  const GotoTable &getGOTOs() const { return GOTOs; }
+
+  void traceItemSets(ItemSet &set) {
+    const SymbolTable &symbols = grammar->getSymbols();
+    std::unordered_set<Item, ItemHash> cache(set.begin(), set.end());
+    // set grows while it is scanned, so added items are closed as well.
+    for (size_t i = 0; i < set.size(); i++) {
+      Symbol name = set[i].next;
+      if (name == NO_SYMBOL || !symbols.isNonterminal(name))
+        continue;
+      for (int rule : grammar->getRules(name)) {
+        Item t(*grammar, rule, 0);
+        if (cache.insert(t).second)
+          set.push_back(t);
+      }
+    }
+  }
+
+  int searchAll(const ItemSet &set) {
+    int a = 0;
+    for (const auto &i : itemSets) {
+      if (set == i)
+        return a;
+      a++;
+    }
+    return -1;
+  }
+
+  void getNextItemSet(const ItemSet &set) {
+    const SymbolTable &symbols = grammar->getSymbols();
+    std::unordered_map<Symbol, int> gos;
+    std::unordered_map<Symbol, Action> acts;
+    for (const auto &outport : set.getNexts()) {
+      Symbol output_name = outport.first;
+      if (output_name == NO_SYMBOL) {
+        for (size_t idx : outport.second) {
+          Symbol lhs = grammar->getProduction(set[idx].rule).lhs;
+          for (int t : grammar->getFollowSet(lhs)) {
+            Symbol follow = symbols.terminals()[t];
+            if (lhs == grammar->getStart()) {
+              acts[follow] = {ACCEPT, -1};
+            } else {
+              if (acts.count(follow))
+                throw std::runtime_error("Not SLR Grammar");
+              acts[follow] = {REDUCE, set[idx].rule};
+            }
+          }
+        }
+        continue;
+      }
+      ItemSet new_set;
+      for (size_t idx : outport.second)
+        new_set.push_back(set[idx].toNext(*grammar));
+      // Stored sets are closed, so close this one before looking it up.
+      traceItemSets(new_set);
+      int a = searchAll(new_set);
+      if (a == -1) {
+        a = itemSets.size();
+        itemSets.push_back(new_set);
+      }
+      if (symbols.isNonterminal(output_name)) {
+        non.insert(output_name);
+        gos[output_name] = a;
+      } else {
+        ter.insert(output_name);
+        if (acts.count(output_name))
+          throw std::runtime_error("Not SLR Grammar");
+        acts[output_name] = {SHIFT, a};
+      }
+    }
+    GOTOs.push_back(gos);
+    ACTIONs.push_back(acts);
+  }
+
+  void buildItemSets() {
+    Symbol target = grammar->getStart();
+    Item t(*grammar, grammar->getRules(target)[0], 0);
+    ItemSet it;
+    it.push_back(t);
+    traceItemSets(it);
+    itemSets.push_back(it);
+    routh[t] = 0;
+    // itemSets grows as the loop runs, so index rather than iterate.
+    while (global_idx < itemSets.size()) {
+      if (trace) {
+        std::cout << global_idx << "\n";
+        printItemSet(itemSets[global_idx]);
+      }
+      ItemSet cur_itemset = itemSets[global_idx];
+      getNextItemSet(cur_itemset);
+      global_idx++;
+    }
+  }
+
+  void printItemSet(const ItemSet &set) {
+    printSeperater(3);
+    for (const auto &item : set) {
+      std::cout << "|| " << item.getProduction(*grammar) << std::endl;
+    }
+    printSeperater(3);
+  }
+
+  void displayACTIONs() {
+    const SymbolTable &symbols = grammar->getSymbols();
+    std::cout << '\t';
+    for (auto name : ter)
+      std::cout << symbols.name(name) << "\t";
+    std::cout << std::endl;
+    int i = 0;
+    for (auto line : ACTIONs) {
+      std::cout << i << '\t';
+      i++;
+      for (auto name : ter) {
+        auto it = line.find(name);
+        if (it != line.end())
+          std::cout << actionText(it->second);
+        else
+          std::cout << Epsilon;
+        std::cout << "\t";
+      }
+      std::cout << std::endl;
+    }
+  }
+
+  void displayGOTOs() {
+    const SymbolTable &symbols = grammar->getSymbols();
+    std::cout << '\t';
+    for (auto name : non)
+      std::cout << symbols.name(name) << "\t";
+    std::cout << std::endl;
+    int i = 0;
+    for (auto line : GOTOs) {
+      std::cout << i << '\t';
+      i++;
+      for (auto name : non) {
+        auto it = line.find(name);
+        if (it != line.end())
+          std::cout << it->second;
+        else
+          std::cout << Epsilon;
+        std::cout << "\t";
+      }
+      std::cout << std::endl;
+    }
+  }
+
+  void displayRouth() {
+    for (auto it = routh.begin(); it != routh.end(); it++) {
+      auto item = it->first;
+      int next = it->second;
+      std::cout << item.getProduction(*grammar) << ": " << next << std::endl;
+    }
+  }
+
+  void setInputs(const std::string &str) { inputs = StringInput(str); }
+  template <typename T> void popn(std::stack<T> &s, int size) {
+    for (int i = 0; i < size; i++)
+      s.pop();
+  }
+
+  void analysis(bool verbose) { analysis(inputs, verbose); }
+
+  // Builds the parse tree of each analysis into tree, or none if it is
+  // null. Terminals refer to their tokens by input position.
+  void buildTree(ParseTree *tree) { this->tree = tree; }
+
+  template <typename Input> void analysis(Input &input, bool verbose) {
+    const SymbolTable &symbols = grammar->getSymbols();
+    std::cout << "步骤\t"
+              << "状态栈\t\t"
+              << "符号栈\t\t"
+              << "输入串\t\t"
+              << "分析动作\t"
+              << "下一状态\t" << std::endl;
+
+    int step = 1;
+    if (tree)
+      tree->clear();
+    stack.push(SymbolTable::END);
+    status.push(0);
+    while (1) {
+      std::string next_status = Epsilon;
+      if (verbose) {
+        std::cout << step << '\t';
+        printStack(status);
+        std::cout << "\t\t";
+        printStack(stack, symbols);
+        std::cout << "\t\t";
+        input.print();
+        std::cout << "\t\t";
+      }
+      int top = status.top();
+      Symbol inp = symbols.findTerminal(input.peek());
+      auto found = ACTIONs[top].find(inp);
+      if (found == ACTIONs[top].end())
+        throw std::runtime_error("No SLR action for " + input.peek());
+      Action action = found->second;
+      if (action.kind == SHIFT) {
+        if (tree)
+          tree->shift(inp, input.position());
+        status.push(action.target);
+        input.advance();
+        stack.push(inp);
+      } else {
+        if (action.kind == ACCEPT) {
+          if (tree)
+            tree->finish();
+          break;
+        }
+        Symbol name = grammar->getProduction(action.target).lhs;
+        size_t size = grammar->getRhs(action.target).size();
+        if (tree)
+          tree->reduce(name, action.target, size);
+        popn(status, size);
+        popn(stack, size);
+        stack.push(name);
+        auto &gos = GOTOs[status.top()];
+        auto it = gos.find(name);
+        if (it != gos.end()) {
+          next_status = std::to_string(it->second);
+          status.push(it->second);
+        }
+      }
+      if (verbose) {
+        std::cout << actionText(action) << "\t\t";
+        std::cout << next_status << std::endl;
+      }
+      step++;
+    }
+    std::cout << "ACC";
+  }
+
+private:
+  // S<state>, R<nonterminal><alternative> or ACC-1, as the tables show them.
+  std::string actionText(const Action &action) {
+    if (action.kind == SHIFT)
+      return "S" + std::to_string(action.target);
+    if (action.kind == ACCEPT)
+      return "ACC-1";
+    const Production &p = grammar->getProduction(action.target);
+    return "R" + grammar->getSymbols().name(p.lhs) +
+           std::to_string(p.alternative);
+  }
+
+  std::vector<ItemSet> itemSets;
+  std::unordered_map<Item, int, ItemHash> routh;
+  ActionTable ACTIONs;
+  GotoTable GOTOs;
+  std::stack<Symbol> stack;
+  std::stack<int> status;
+  ParseTree *tree = nullptr;
+  StringInput inputs;
+  std::set<Symbol> non, ter;
+  bool trace;
+  size_t global_idx;
+  Grammar *grammar;
+};
+
+#endif
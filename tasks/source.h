@@ -0,0 +1,108 @@
+#ifndef COMPILEWORK_SOURCE_H
+#define COMPILEWORK_SOURCE_H
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only mapping of a whole source file. The Lexer works on the mapped
+// bytes directly, so nothing is copied before the first token.
+class MappedFile {
+public:
+  MappedFile() : data(nullptr), size(0) {}
+  explicit MappedFile(const char *path) : MappedFile() { open(path); }
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  ~MappedFile() { close(); }
+
+  void open(const char *path) {
+    close();
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+      throw std::runtime_error("Cannot open " + std::string(path) + ": " +
+                               std::strerror(errno));
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+      int err = errno;
+      ::close(fd);
+      throw std::runtime_error("Cannot stat " + std::string(path) + ": " +
+                               std::strerror(err));
+    }
+    size = st.st_size;
+    if (size > 0) {
+      void *addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr == MAP_FAILED) {
+        int err = errno;
+        ::close(fd);
+        size = 0;
+        throw std::runtime_error("Cannot map " + std::string(path) + ": " +
+                                 std::strerror(err));
+      }
+      madvise(addr, size, MADV_SEQUENTIAL);
+      data = static_cast<const char *>(addr);
+    }
+    ::close(fd);
+  }
+
+  void close() {
+    if (data)
+      munmap(const_cast<char *>(data), size);
+    data = nullptr;
+    size = 0;
+  }
+
+  std::string_view view() const { return std::string_view(data, size); }
+
+private:
+  const char *data;
+  size_t size;
+};
+
+// Opens a source file for StreamLexer; a null path streams stdin instead.
+inline int openSourceFd(const char *path) {
+  if (!path)
+    return STDIN_FILENO;
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error("Cannot open " + std::string(path) + ": " +
+                             std::strerror(errno));
+  return fd;
+}
+
+inline bool hasFlag(int argc, char *argv[], const char *flag) {
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], flag) == 0)
+      return true;
+  }
+  return false;
+}
+
+// Returns the text after prefix of the first argument starting with it, e.g.
+// "64" for --repeat=64 with prefix "--repeat=".
+inline const char *getFlagValue(int argc, char *argv[], const char *prefix) {
+  size_t len = std::strlen(prefix);
+  for (int i = 1; i < argc; i++) {
+    if (std::strncmp(argv[i], prefix, len) == 0)
+      return argv[i] + len;
+  }
+  return nullptr;
+}
+
+// The first argument that is not a --flag names the source file; without one
+// the drivers keep reading the program from stdin.
+inline const char *getSourcePath(int argc, char *argv[]) {
+  for (int i = 1; i < argc; i++) {
+    if (std::strncmp(argv[i], "--", 2) != 0)
+      return argv[i];
+  }
+  return nullptr;
+}
+
+#endif
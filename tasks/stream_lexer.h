@@ -0,0 +1,102 @@
+#ifndef COMPILEWORK_STREAM_LEXER_H
+#define COMPILEWORK_STREAM_LEXER_H
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+#include "lexer.h"
+
+// Runs the table-driven DFA over a file descriptor read in fixed-size chunks,
+// so a program never has to be resident as a whole. The window only keeps the
+// token being scanned: blanks and comments are dropped as soon as they are
+// consumed, and the DFA state survives a refill, so tokens and comments may
+// straddle chunk boundaries. Memory is one chunk plus the longest token.
+//
+// Tokens index into the window, so a lexeme is only valid until the next
+// getTokenType() call.
+class StreamLexer {
+public:
+  StreamLexer(int fd, size_t chunk_size = 64 * 1024)
+      : fd(fd), chunk_size(chunk_size), filled(0), pos(0), lexemeStart(0),
+        lexemeLength(0), cur_line(1), eof(false) {
+    if (chunk_size == 0)
+      throw std::runtime_error("Chunk size must be positive");
+    buffer.resize(chunk_size);
+  }
+
+  TokenType getTokenType() {
+    using namespace lexdfa;
+    size_t start = pos;
+    uint8_t state = S_START;
+    while (!scan(buffer.data(), pos, filled, state, start, cur_line)) {
+      if (isSkipState(state))
+        start = pos;
+      if (!refill(start))
+        break;
+    }
+
+    TokenType type = acceptState(state, getSource(), start, pos);
+    lexemeStart = start;
+    lexemeLength = pos - start;
+    return type;
+  }
+
+  Token buildToken(TokenType type) {
+    return Token(lexemeStart, lexemeLength, type, cur_line);
+  }
+
+  std::string_view getLexeme(const Token &token) const {
+    return token.getLexeme(getSource());
+  }
+
+  std::string_view getSource() const {
+    return std::string_view(buffer.data(), filled);
+  }
+
+private:
+  // Drops everything before keep, then appends one chunk. Returns false once
+  // the descriptor is exhausted.
+  bool refill(size_t &keep) {
+    if (eof)
+      return false;
+    if (keep > 0) {
+      std::memmove(buffer.data(), buffer.data() + keep, filled - keep);
+      filled -= keep;
+      pos -= keep;
+      keep = 0;
+    }
+    if (buffer.size() < filled + chunk_size)
+      buffer.resize(filled + chunk_size);
+    ssize_t n;
+    do {
+      n = read(fd, buffer.data() + filled, chunk_size);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0)
+      throw std::runtime_error(std::string("Read failed: ") +
+                               std::strerror(errno));
+    if (n == 0) {
+      eof = true;
+      return false;
+    }
+    if (filled + n > UINT32_MAX)
+      throw std::runtime_error("Token larger than 4GiB");
+    filled += n;
+    return true;
+  }
+
+  int fd;
+  size_t chunk_size;
+  std::vector<char> buffer;
+  size_t filled, pos;
+  uint32_t lexemeStart, lexemeLength;
+  int cur_line;
+  bool eof;
+};
+
+#endif
@@ -0,0 +1,535 @@
+#ifndef COMPILEWORK_TABLE_IMAGE_H
+#define COMPILEWORK_TABLE_IMAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "grammar.h"
+#include "slr_parser.h"
+#include "source.h"
+
+// A grammar, its analyses and its parse tables laid out flat, so a later run
+// maps the file and reads them in place instead of analysing the grammar
+// again. All integers are in host byte order; an image is only meant for
+// the machine, or at least the byte order, that wrote it.
+//
+//   TableImageHeader
+//   sections, each at the 8-byte aligned offset the header gives:
+//     NAMES        char: symbol names, then production texts
+//     SYMBOLS      uint32 x3 per symbol: name offset, name length, 1 for a
+//                  nonterminal; symbols keep their SymbolTable ids
+//     PRODUCTIONS  uint32 x6 per production: lhs, alternative, rhs begin,
+//                  rhs end, text offset, text length
+//     RHS          int32 per right-hand side symbol
+//     NULLABLE     uint8 per nonterminal
+//     FIRST        uint64 x set_words per nonterminal
+//     FOLLOW       uint64 x set_words per nonterminal
+//     SELECT       uint64 x set_words per production
+//     PREDICT      int32 [nonterminal][terminal] rule or NO_RULE; LL(1) only
+//     ACTION       int32 [state][terminal] action code or -1; SLR only
+//     GOTO         int32 [state][nonterminal] state or -1; SLR only
+//
+// The checksum covers the whole image, its own field taken as zero, and the
+// version changes whenever the layout does. The grammar hash covers only the
+// start symbol and the productions, so a loader can tell an image of some
+// other grammar from an up to date one.
+
+enum ImageSection {
+  IMAGE_NAMES,
+  IMAGE_SYMBOLS,
+  IMAGE_PRODUCTIONS,
+  IMAGE_RHS,
+  IMAGE_NULLABLE,
+  IMAGE_FIRST,
+  IMAGE_FOLLOW,
+  IMAGE_SELECT,
+  IMAGE_PREDICT,
+  IMAGE_ACTION,
+  IMAGE_GOTO,
+  IMAGE_SECTIONS
+};
+
+enum ImageFlags { IMAGE_HAS_PREDICT = 1, IMAGE_HAS_SLR = 2 };
+
+struct TableImageHeader {
+  char magic[8];
+  uint32_t version, flags;
+  uint64_t size, checksum, grammar;
+  uint32_t symbols, nonterminals, terminals, productions;
+  uint32_t rhs_symbols, states, start, set_words;
+  // Byte offset and length of each section.
+  uint64_t offsets[IMAGE_SECTIONS], lengths[IMAGE_SECTIONS];
+};
+static_assert(sizeof(TableImageHeader) % 8 == 0,
+              "sections and the checksum work in 8-byte words");
+
+// FNV-1a taken a 64-bit word at a time instead of a byte at a time; size
+// is a multiple of 8. hash continues an earlier call.
+inline uint64_t imageChecksum(const char *data, size_t size,
+                              uint64_t hash = 0xcbf29ce484222325) {
+  for (size_t i = 0; i < size; i += 8) {
+    uint64_t word;
+    std::memcpy(&word, data + i, 8);
+    hash = (hash ^ word) * 0x100000001b3;
+  }
+  return hash;
+}
+
+class TableImage {
+public:
+  static constexpr char MAGIC[8] = {'P', 'L', '0', 'T', 'A', 'B', 'L', 'E'};
+  static constexpr uint32_t VERSION = 2;
+
+  // Hash of G's start symbol and productions, in rule order, by name.
+  static uint64_t grammarHash(const Grammar &G) {
+    const SymbolTable &symbols = G.symbols;
+    std::string text = symbols.name(G.start) + '\n';
+    for (const Production &p : G.rules) {
+      text += symbols.name(p.lhs);
+      for (uint32_t i = p.begin; i < p.end; i++)
+        text += ' ' + symbols.name(G.rule_symbols[i]);
+      text += '\n';
+    }
+    text.resize((text.size() + 7) & ~size_t(7), '\0');
+    return imageChecksum(text.data(), text.size());
+  }
+
+  // Analyses G and lays out its image. The predict table is included when G
+  // is LL(1), and the SLR tables when slr is set and G is SLR; building the
+  // item sets is by far the slowest part for large grammars.
+  static std::string build(Grammar &G, bool slr = true) {
+    const SymbolTable &symbols = G.symbols;
+    TableImageHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.symbols = symbols.size();
+    header.nonterminals = symbols.nonterminals().size();
+    header.terminals = symbols.terminals().size();
+    header.productions = G.rules.size();
+    header.rhs_symbols = G.rule_symbols.size();
+    header.start = G.start;
+    header.grammar = grammarHash(G);
+    G.getAllSelectSet();
+    header.set_words = TerminalSet(header.terminals).wordCount();
+
+    std::string out(sizeof(header), '\0');
+    auto section = [&](ImageSection s, const void *data, size_t bytes) {
+      out.resize((out.size() + 7) & ~size_t(7), '\0');
+      header.offsets[s] = out.size();
+      header.lengths[s] = bytes;
+      out.append(static_cast<const char *>(data), bytes);
+    };
+
+    std::string names;
+    std::vector<uint32_t> symbol_data, production_data;
+    for (size_t s = 0; s < symbols.size(); s++) {
+      symbol_data.insert(symbol_data.end(),
+                         {uint32_t(names.size()),
+                          uint32_t(symbols.name(s).size()),
+                          uint32_t(symbols.isNonterminal(s))});
+      names += symbols.name(s);
+    }
+    for (size_t rule = 0; rule < G.rules.size(); rule++) {
+      const Production &p = G.rules[rule];
+      const std::string &text = G.getProductionText(rule);
+      production_data.insert(production_data.end(),
+                             {uint32_t(p.lhs), uint32_t(p.alternative),
+                              p.begin, p.end, uint32_t(names.size()),
+                              uint32_t(text.size())});
+      names += text;
+    }
+    section(IMAGE_NAMES, names.data(), names.size());
+    section(IMAGE_SYMBOLS, symbol_data.data(), symbol_data.size() * 4);
+    section(IMAGE_PRODUCTIONS, production_data.data(),
+            production_data.size() * 4);
+    section(IMAGE_RHS, G.rule_symbols.data(), G.rule_symbols.size() * 4);
+    section(IMAGE_NULLABLE, G.nullable.data(), G.nullable.size());
+    auto sets = [&](ImageSection s, const std::vector<TerminalSet> &cache) {
+      std::vector<uint64_t> words;
+      for (const auto &set : cache)
+        words.insert(words.end(), set.wordData(),
+                     set.wordData() + set.wordCount());
+      section(s, words.data(), words.size() * 8);
+    };
+    sets(IMAGE_FIRST, G.firstCache);
+    sets(IMAGE_FOLLOW, G.followCache);
+    sets(IMAGE_SELECT, G.selectCache);
+
+    try {
+      TableType table;
+      buildPredcitTable(G, table);
+      std::vector<int32_t> flat;
+      for (const auto &row : table)
+        flat.insert(flat.end(), row.begin(), row.end());
+      section(IMAGE_PREDICT, flat.data(), flat.size() * 4);
+      header.flags |= IMAGE_HAS_PREDICT;
+    } catch (const std::runtime_error &) {
+      // Not LL(1): the image simply has no predict table.
+    }
+
+    try {
+      if (!slr)
+        throw std::runtime_error("SLR tables not wanted");
+      SLRParser parser(&G, false);
+      const auto &actions = parser.getACTIONs();
+      const auto &gotos = parser.getGOTOs();
+      header.states = actions.size();
+      std::vector<int32_t> action_data(header.states * header.terminals, -1);
+      std::vector<int32_t> goto_data(header.states * header.nonterminals,
+                                     -1);
+      for (size_t state = 0; state < actions.size(); state++) {
+        for (const auto &entry : actions[state])
+          action_data[state * header.terminals +
+                      symbols.index(entry.first)] = encode(entry.second);
+        for (const auto &entry : gotos[state])
+          goto_data[state * header.nonterminals +
+                    symbols.index(entry.first)] = entry.second;
+      }
+      section(IMAGE_ACTION, action_data.data(), action_data.size() * 4);
+      section(IMAGE_GOTO, goto_data.data(), goto_data.size() * 4);
+      header.flags |= IMAGE_HAS_SLR;
+    } catch (const std::runtime_error &) {
+      // Not SLR, or not wanted: no ACTION and GOTO tables.
+      header.states = 0;
+    }
+
+    out.resize((out.size() + 7) & ~size_t(7), '\0');
+    header.size = out.size();
+    std::memcpy(&out[0], &header, sizeof(header));
+    header.checksum = checksum(out);
+    std::memcpy(&out[0], &header, sizeof(header));
+    return out;
+  }
+
+  TableImage() : header(nullptr) {}
+  // Maps the image at path and checks it.
+  explicit TableImage(const char *path)
+      : file(std::make_unique<MappedFile>(path)), header(nullptr) {
+    check(file->view());
+  }
+  // Checks an image held in memory, e.g. just built. Moving a TableImage
+  // keeps the mapping or buffer, so views into it stay valid.
+  explicit TableImage(std::string image)
+      : owned(std::move(image)), header(nullptr) {
+    check(owned);
+  }
+
+  bool hasPredictTable() const { return header->flags & IMAGE_HAS_PREDICT; }
+  bool hasSLRTables() const { return header->flags & IMAGE_HAS_SLR; }
+  size_t grammarTerminals() const { return header->terminals; }
+  // grammarHash() of the grammar the image was built from.
+  uint64_t builtFrom() const { return header->grammar; }
+  size_t size() const { return bytes.size(); }
+
+  // The grammar with its nullable, FIRST, FOLLOW and SELECT sets filled in
+  // from the image; nothing is analysed again.
+  Grammar grammar() const {
+    Grammar G;
+    G.symbols.reserve(header->symbols);
+    G.nonterminals.reserve(header->nonterminals);
+    G.rules.reserve(header->productions);
+    const uint32_t *symbol_data = array<uint32_t>(IMAGE_SYMBOLS);
+    for (uint32_t s = 0; s < header->symbols; s++) {
+      const uint32_t *entry = symbol_data + 3 * s;
+      std::string name = text(entry[0], entry[1]);
+      // The SymbolTable starts with epsilon and #; ids must not move.
+      if (s < 2 ? G.symbols.find(name) != Symbol(s)
+                : G.symbols.intern(name, entry[2]) != Symbol(s))
+        throw std::runtime_error("Bad table image: symbol " + name);
+      if (entry[2])
+        G.nonterminals.emplace_back(name);
+    }
+    if (header->start >= header->symbols ||
+        !G.symbols.isNonterminal(header->start))
+      throw std::runtime_error("Bad table image: start symbol");
+    G.start = header->start;
+    G.start_symbol = G.symbols.name(G.start);
+
+    const uint32_t *production_data = array<uint32_t>(IMAGE_PRODUCTIONS);
+    const int32_t *rhs = array<int32_t>(IMAGE_RHS);
+    G.rule_symbols.assign(rhs, rhs + header->rhs_symbols);
+    for (Symbol s : G.rule_symbols) {
+      if (s < 0 || uint32_t(s) >= header->symbols)
+        throw std::runtime_error("Bad table image: production symbol");
+    }
+    // Production ids need not follow the alternatives once a grammar has
+    // been edited, so each production goes in its alternative's slot.
+    for (uint32_t rule = 0; rule < header->productions; rule++) {
+      const uint32_t *entry = production_data + 6 * rule;
+      if (entry[0] >= header->symbols || !G.symbols.isNonterminal(entry[0]))
+        throw std::runtime_error("Bad table image: production");
+      G.nonterminals[G.symbols.index(entry[0])].rules.push_back(NO_RULE);
+    }
+    for (auto &node : G.nonterminals) {
+      node.productions.resize(node.rules.size());
+      node.production_symbols.resize(node.rules.size());
+    }
+    for (uint32_t rule = 0; rule < header->productions; rule++) {
+      const uint32_t *entry = production_data + 6 * rule;
+      Production p{Symbol(entry[0]), int(entry[1]), entry[2], entry[3]};
+      Nonterminal &node = G.nonterminals[G.symbols.index(p.lhs)];
+      if (p.begin > p.end || p.end > header->rhs_symbols ||
+          entry[1] >= node.rules.size() || node.rules[entry[1]] != NO_RULE)
+        throw std::runtime_error("Bad table image: production");
+      node.productions[p.alternative] = text(entry[4], entry[5]);
+      for (uint32_t i = p.begin; i < p.end; i++)
+        node.production_symbols[p.alternative].push_back(
+            G.symbols.name(G.rule_symbols[i]));
+      node.rules[p.alternative] = rule;
+      G.rules.push_back(p);
+    }
+    for (auto &node : G.nonterminals)
+      node.symbol = G.symbols.find(node.name);
+
+    const uint8_t *nullable = array<uint8_t>(IMAGE_NULLABLE);
+    G.nullable.assign(nullable, nullable + header->nonterminals);
+    for (size_t i = 0; i < G.nonterminals.size(); i++)
+      G.nonterminals[i].generallyEmpty = G.nullable[i];
+    G.firstCache = sets(IMAGE_FIRST, header->nonterminals);
+    G.followCache = sets(IMAGE_FOLLOW, header->nonterminals);
+    G.selectCache = sets(IMAGE_SELECT, header->productions);
+    G.firstDone = G.followDone = G.selectDone = true;
+    return G;
+  }
+
+  // The predict table in place: the rule for nonterminal index n and
+  // terminal index t is at [n * terminals + t]. Entries were range checked
+  // when the image was opened.
+  const int32_t *predictCells() const {
+    if (!hasPredictTable())
+      throw std::runtime_error("Not LL(1) Grammar");
+    return array<int32_t>(IMAGE_PREDICT);
+  }
+
+  // A parser over the stored ACTION and GOTO tables; G must come from
+  // grammar() of this image.
+  SLRParser slrParser(Grammar *G) const {
+    if (!hasSLRTables())
+      throw std::runtime_error("Not SLR Grammar");
+    const SymbolTable &symbols = G->getSymbols();
+    const int32_t *action_data = array<int32_t>(IMAGE_ACTION);
+    const int32_t *goto_data = array<int32_t>(IMAGE_GOTO);
+    SLRParser::ActionTable actions(header->states);
+    SLRParser::GotoTable gotos(header->states);
+    for (uint32_t state = 0; state < header->states; state++) {
+      for (uint32_t t = 0; t < header->terminals; t++) {
+        int32_t code = action_data[size_t(state) * header->terminals + t];
+        if (code >= 0)
+          actions[state][symbols.terminals()[t]] = decode(code);
+      }
+      for (uint32_t non = 0; non < header->nonterminals; non++) {
+        int32_t next = goto_data[size_t(state) * header->nonterminals + non];
+        if (next >= 0)
+          gotos[state][symbols.nonterminals()[non]] = next;
+      }
+    }
+    return SLRParser(G, std::move(actions), std::move(gotos));
+  }
+
+private:
+  // SHIFT and REDUCE keep their target above the two kind bits.
+  static int32_t encode(const Action &action) {
+    return action.kind == ACCEPT ? ACCEPT : action.target << 2 | action.kind;
+  }
+  static Action decode(int32_t code) {
+    ActionKind kind = ActionKind(code & 3);
+    return {kind, kind == ACCEPT ? -1 : code >> 2};
+  }
+
+  static uint64_t checksum(std::string_view image) {
+    TableImageHeader header;
+    std::memcpy(&header, image.data(), sizeof(header));
+    header.checksum = 0;
+    uint64_t hash = imageChecksum(reinterpret_cast<const char *>(&header),
+                                  sizeof(header));
+    return imageChecksum(image.data() + sizeof(header),
+                         image.size() - sizeof(header), hash);
+  }
+
+  // Every section must lie inside the image, be aligned for its element
+  // type and be exactly as long as the counts in the header make it.
+  void check(std::string_view image) {
+    if (image.size() < sizeof(TableImageHeader) ||
+        reinterpret_cast<uintptr_t>(image.data()) % 8 != 0)
+      throw std::runtime_error("Bad table image: too short");
+    header = reinterpret_cast<const TableImageHeader *>(image.data());
+    if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0)
+      throw std::runtime_error("Bad table image: not a table image");
+    if (header->version != VERSION)
+      throw std::runtime_error("Bad table image: version " +
+                               std::to_string(header->version));
+    if (header->size != image.size() || image.size() % 8 != 0)
+      throw std::runtime_error("Bad table image: truncated");
+    if (checksum(image) != header->checksum)
+      throw std::runtime_error("Bad table image: checksum mismatch");
+    bytes = image;
+
+    size_t words = header->set_words;
+    uint64_t expected[IMAGE_SECTIONS] = {
+        header->lengths[IMAGE_NAMES],
+        header->symbols * 12ull,
+        header->productions * 24ull,
+        header->rhs_symbols * 4ull,
+        header->nonterminals * 1ull,
+        header->nonterminals * words * 8,
+        header->nonterminals * words * 8,
+        header->productions * words * 8,
+        hasPredictTable() ? header->nonterminals * header->terminals * 4ull
+                          : 0,
+        hasSLRTables() ? header->states * header->terminals * 4ull : 0,
+        hasSLRTables() ? header->states * header->nonterminals * 4ull : 0};
+    if (words != TerminalSet(header->terminals).wordCount() ||
+        header->nonterminals + header->terminals != header->symbols)
+      throw std::runtime_error("Bad table image: counts");
+    for (int s = 0; s < IMAGE_SECTIONS; s++) {
+      uint64_t offset = header->offsets[s], length = header->lengths[s];
+      if (length == 0 && expected[s] == 0)
+        continue;
+      if (length != expected[s] || offset % 8 != 0 ||
+          offset < sizeof(TableImageHeader) || offset > bytes.size() ||
+          length > bytes.size() - offset)
+        throw std::runtime_error("Bad table image: section " +
+                                 std::to_string(s));
+    }
+    // The parsers index productions with these without further checks.
+    if (hasPredictTable()) {
+      // NO_RULE is -1, so every entry plus one is at most productions. No
+      // early exit, which lets the loop vectorise.
+      const int32_t *cells = array<int32_t>(IMAGE_PREDICT);
+      uint32_t limit = header->productions;
+      bool bad = false;
+      for (size_t i = 0; i < expected[IMAGE_PREDICT] / 4; i++)
+        bad |= uint32_t(cells[i]) + 1 > limit;
+      if (bad)
+        throw std::runtime_error("Bad table image: predict entry");
+    }
+  }
+
+  template <typename T> const T *array(ImageSection s) const {
+    return reinterpret_cast<const T *>(bytes.data() + header->offsets[s]);
+  }
+
+  std::string text(uint32_t offset, uint32_t length) const {
+    if (uint64_t(offset) + length > header->lengths[IMAGE_NAMES])
+      throw std::runtime_error("Bad table image: name");
+    return std::string(array<char>(IMAGE_NAMES) + offset, length);
+  }
+
+  std::vector<TerminalSet> sets(ImageSection s, size_t count) const {
+    const uint64_t *words = array<uint64_t>(s);
+    std::vector<TerminalSet> result;
+    result.reserve(count);
+    for (size_t i = 0; i < count; i++)
+      result.emplace_back(words + i * header->set_words, header->set_words);
+    return result;
+  }
+
+  std::unique_ptr<MappedFile> file;
+  std::string owned;
+  std::string_view bytes;
+  const TableImageHeader *header;
+};
+
+// The LL(1) predict table as one row-major array, either built from a
+// grammar or read in place from a TableImage, which it then keeps.
+class PredictCells {
+public:
+  explicit PredictCells(Grammar &G)
+      : width(G.getSymbols().terminals().size()) {
+    TableType rows;
+    buildPredcitTable(G, rows);
+    for (const auto &row : rows)
+      owned.insert(owned.end(), row.begin(), row.end());
+    cells = owned.data();
+  }
+  // A table that lives as long as the program, e.g. PL0_GRAMMAR's.
+  PredictCells(const int32_t *cells, size_t width)
+      : cells(cells), width(width) {}
+  explicit PredictCells(TableImage image)
+      : image(std::move(image)), cells(this->image.predictCells()),
+        width(this->image.grammarTerminals()) {}
+
+  // The rule for nonterminal index non on terminal index t, or NO_RULE.
+  int operator()(int non, int t) const {
+    return cells[size_t(non) * width + t];
+  }
+
+private:
+  TableImage image;
+  std::vector<int32_t> owned;
+  const int32_t *cells;
+  size_t width;
+};
+
+// Writes image to path through a temporary file of its own in the same
+// directory, so a reader never maps a half-written image and two writers
+// never share one.
+inline void saveTableImage(const std::string &image, const std::string &path) {
+  std::string temp = path + ".XXXXXX";
+  int fd = mkstemp(&temp[0]);
+  if (fd < 0)
+    throw std::runtime_error("Cannot write " + path + ": " +
+                             std::strerror(errno));
+  // mkstemp makes the file private; give it the mode a plain create would.
+  mode_t mask = umask(0);
+  umask(mask);
+  fchmod(fd, 0666 & ~mask);
+  const char *data = image.data();
+  size_t left = image.size();
+  int error = 0;
+  while (left > 0 && error == 0) {
+    ssize_t n = write(fd, data, left);
+    if (n > 0) {
+      data += n;
+      left -= n;
+    } else if (n == 0 || errno != EINTR) {
+      error = n == 0 ? EIO : errno;
+    }
+  }
+  if (close(fd) != 0 && error == 0)
+    error = errno;
+  if (error == 0 && std::rename(temp.c_str(), path.c_str()) != 0)
+    error = errno;
+  if (error != 0) {
+    unlink(temp.c_str());
+    throw std::runtime_error("Cannot write " + path + ": " +
+                             std::strerror(error));
+  }
+}
+
+// The image at path. When there is none, it cannot be used or it was built
+// from other productions than build() gives, the tables are built from
+// build() and written there for the next run. Only the symbols are interned
+// to compare the grammars; nothing is analysed unless the image is rebuilt.
+inline TableImage loadTableImage(const char *path, Grammar *(*build)()) {
+  std::unique_ptr<Grammar> G(build());
+  try {
+    TableImage image(path);
+    if (image.builtFrom() != TableImage::grammarHash(*G))
+      throw std::runtime_error("built from another grammar");
+    return image;
+  } catch (const std::runtime_error &ex) {
+    if (access(path, F_OK) == 0)
+      std::cerr << "Rebuilding " << path << ": " << ex.what() << "\n";
+  }
+  std::string image = TableImage::build(*G);
+  try {
+    saveTableImage(image, path);
+  } catch (const std::runtime_error &ex) {
+    std::cerr << ex.what() << "\n";
+  }
+  return TableImage(std::move(image));
+}
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef COMPILEWORK_TERMINAL_SET_H
+#define COMPILEWORK_TERMINAL_SET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+// A set of terminals kept as a bitset over their SymbolTable::index(), so a
+// union is a few word ORs. Iteration yields the indices in increasing order.
+class TerminalSet {
+public:
+  class const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = int;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const int *;
+    using reference = int;
+
+    const_iterator(const uint64_t *words, size_t size, size_t word)
+        : words(words), size(size), word(word),
+          bits(word < size ? words[word] : 0) {
+      skip();
+    }
+
+    int operator*() const { return word * 64 + __builtin_ctzll(bits); }
+
+    const_iterator &operator++() {
+      bits &= bits - 1;
+      skip();
+      return *this;
+    }
+
+    bool operator==(const const_iterator &other) const {
+      return word == other.word && bits == other.bits;
+    }
+    bool operator!=(const const_iterator &other) const {
+      return !(*this == other);
+    }
+
+  private:
+    // Moves to the next word with a member, or to the end.
+    void skip() {
+      while (bits == 0 && word < size) {
+        if (++word < size)
+          bits = words[word];
+      }
+    }
+
+    const uint64_t *words;
+    size_t size, word;
+    uint64_t bits;
+  };
+
+  TerminalSet(size_t terminals = 0) : words((terminals + 63) / 64, 0) {}
+  // From words as wordData() lays them out, e.g. read back from a file.
+  TerminalSet(const uint64_t *data, size_t count) : words(data, data + count) {}
+
+  void insert(int t) { words[t >> 6] |= uint64_t(1) << (t & 63); }
+  void erase(int t) { words[t >> 6] &= ~(uint64_t(1) << (t & 63)); }
+  bool contains(int t) const { return words[t >> 6] >> (t & 63) & 1; }
+  // Makes room for terminals up to the given count; members are kept.
+  void resize(size_t terminals) { words.resize((terminals + 63) / 64, 0); }
+
+  // Adds the members of other, which must cover the same terminals, and
+  // tells whether that added anything.
+  bool merge(const TerminalSet &other) {
+    uint64_t added = 0;
+    for (size_t i = 0; i < words.size(); i++) {
+      added |= other.words[i] & ~words[i];
+      words[i] |= other.words[i];
+    }
+    return added != 0;
+  }
+
+  bool empty() const {
+    for (uint64_t w : words) {
+      if (w)
+        return false;
+    }
+    return true;
+  }
+
+  size_t size() const {
+    size_t n = 0;
+    for (uint64_t w : words)
+      n += __builtin_popcountll(w);
+    return n;
+  }
+
+  const_iterator begin() const {
+    return const_iterator(words.data(), words.size(), 0);
+  }
+  const_iterator end() const {
+    return const_iterator(words.data(), words.size(), words.size());
+  }
+
+  const uint64_t *wordData() const { return words.data(); }
+  size_t wordCount() const { return words.size(); }
+
+  bool operator==(const TerminalSet &other) const {
+    return words == other.words;
+  }
+
+private:
+  std::vector<uint64_t> words;
+};
+
+#endif
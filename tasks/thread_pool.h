@@ -0,0 +1,145 @@
+#ifndef COMPILEWORK_THREAD_POOL_H
+#define COMPILEWORK_THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// A fixed set of worker threads, each with its own deque of tasks. A worker
+// runs its newest task first, which keeps a task's follow-up work on the
+// same core, and when its deque is empty steals the oldest task of another
+// worker. Tasks may submit more tasks; wait() returns once all have run.
+class WorkStealingPool {
+public:
+  // threads == 0 picks one per core.
+  explicit WorkStealingPool(unsigned threads = 0)
+      : queued(0), pending(0), next_queue(0), stopping(false) {
+    if (threads == 0)
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned i = 0; i < threads; i++)
+      queues.push_back(std::make_unique<Queue>());
+    for (unsigned i = 0; i < threads; i++)
+      workers.emplace_back(&WorkStealingPool::work, this, i);
+  }
+
+  ~WorkStealingPool() {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      stopping = true;
+    }
+    wake.notify_all();
+    for (auto &worker : workers)
+      worker.join();
+  }
+
+  WorkStealingPool(const WorkStealingPool &) = delete;
+  WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+  unsigned size() const { return workers.size(); }
+
+  // Called from one of this pool's tasks, the task goes on that worker's
+  // own deque; otherwise the deques take turns.
+  void submit(std::function<void()> task) {
+    unsigned target = current_pool == this
+                          ? current_worker
+                          : next_queue++ % queues.size();
+    pending++;
+    {
+      // Counted before it can be taken, so take() never sees queued at zero
+      // with the task in a deque; nothing takes lock while holding a deque's.
+      std::lock_guard<std::mutex> guard(lock);
+      queued++;
+      std::lock_guard<std::mutex> queue_guard(queues[target]->lock);
+      queues[target]->tasks.push_back(std::move(task));
+    }
+    wake.notify_one();
+  }
+
+  // Blocks until every submitted task has run, then rethrows the first
+  // exception a task threw, if any.
+  void wait() {
+    std::unique_lock<std::mutex> guard(lock);
+    done.wait(guard, [&] { return pending == 0; });
+    if (error) {
+      std::exception_ptr e = std::move(error);
+      error = nullptr;
+      std::rethrow_exception(e);
+    }
+  }
+
+private:
+  struct Queue {
+    std::mutex lock;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  bool take(unsigned self, std::function<void()> &task) {
+    for (unsigned i = 0; i < queues.size(); i++) {
+      Queue &queue = *queues[(self + i) % queues.size()];
+      std::lock_guard<std::mutex> guard(queue.lock);
+      if (queue.tasks.empty())
+        continue;
+      if (i == 0) {
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+      } else {
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+      }
+      queued--;
+      return true;
+    }
+    return false;
+  }
+
+  void work(unsigned self) {
+    current_pool = this;
+    current_worker = self;
+    for (;;) {
+      std::function<void()> task;
+      if (take(self, task)) {
+        try {
+          task();
+        } catch (...) {
+          std::lock_guard<std::mutex> guard(lock);
+          if (!error)
+            error = std::current_exception();
+        }
+        if (--pending == 0) {
+          std::lock_guard<std::mutex> guard(lock);
+          done.notify_all();
+        }
+        continue;
+      }
+      // queued only grows under lock, so a task submitted after take()
+      // looked is seen here rather than missed.
+      std::unique_lock<std::mutex> guard(lock);
+      wake.wait(guard, [&] { return stopping || queued > 0; });
+      if (stopping)
+        return;
+    }
+  }
+
+  static inline thread_local WorkStealingPool *current_pool = nullptr;
+  static inline thread_local unsigned current_worker = 0;
+
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> workers;
+  // Tasks sitting in deques, and tasks submitted but not yet finished.
+  std::atomic<size_t> queued, pending;
+  std::atomic<unsigned> next_queue;
+  std::mutex lock;
+  std::condition_variable wake, done;
+  std::exception_ptr error;
+  bool stopping;
+};
+
+#endif
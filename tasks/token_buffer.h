@@ -0,0 +1,132 @@
+#ifndef COMPILEWORK_TOKEN_BUFFER_H
+#define COMPILEWORK_TOKEN_BUFFER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "lexer.h"
+
+// Used to reserve token storage up front; PL/0 sources average a few bytes
+// of text and blanks per token.
+constexpr size_t AVG_TOKEN_BYTES = 4;
+
+inline size_t estimateTokenCount(size_t source_size) {
+  return source_size / AVG_TOKEN_BYTES + 1;
+}
+
+// Token storage laid out as one array per field, so a pass that only needs
+// the kinds or the line numbers walks a single dense array. Indexing and
+// iteration hand out Token values assembled from the columns.
+class TokenBuffer {
+public:
+  class const_iterator {
+  public:
+    const_iterator(const TokenBuffer *buffer, size_t idx)
+        : buffer(buffer), idx(idx) {}
+    Token operator*() const { return (*buffer)[idx]; }
+    const_iterator &operator++() {
+      idx++;
+      return *this;
+    }
+    bool operator==(const const_iterator &other) const {
+      return idx == other.idx;
+    }
+    bool operator!=(const const_iterator &other) const {
+      return idx != other.idx;
+    }
+
+  private:
+    const TokenBuffer *buffer;
+    size_t idx;
+  };
+
+  TokenBuffer() = default;
+  // Reserves room for the tokens a source of source_size bytes is expected
+  // to hold.
+  explicit TokenBuffer(size_t source_size) {
+    reserve(estimateTokenCount(source_size));
+  }
+
+  void reserve(size_t n) {
+    kinds.reserve(n);
+    offsets.reserve(n);
+    lengths.reserve(n);
+    lines.reserve(n);
+  }
+
+  void resize(size_t n) {
+    kinds.resize(n, END);
+    offsets.resize(n);
+    lengths.resize(n);
+    lines.resize(n);
+  }
+
+  void clear() {
+    kinds.clear();
+    offsets.clear();
+    lengths.clear();
+    lines.clear();
+  }
+
+  void push_back(const Token &token) {
+    kinds.push_back(token.type);
+    offsets.push_back(token.getOffset());
+    lengths.push_back(token.getLength());
+    lines.push_back(token.getLineno());
+  }
+
+  // Appends other's tokens from index from on.
+  void append(const TokenBuffer &other, size_t from = 0) {
+    kinds.insert(kinds.end(), other.kinds.begin() + from, other.kinds.end());
+    offsets.insert(offsets.end(), other.offsets.begin() + from,
+                   other.offsets.end());
+    lengths.insert(lengths.end(), other.lengths.begin() + from,
+                   other.lengths.end());
+    lines.insert(lines.end(), other.lines.begin() + from, other.lines.end());
+  }
+
+  // Copies src over [at, at + src.size()), which must already exist, adding
+  // line_delta to every line number.
+  void place(size_t at, const TokenBuffer &src, int line_delta) {
+    std::copy(src.kinds.begin(), src.kinds.end(), kinds.begin() + at);
+    std::copy(src.offsets.begin(), src.offsets.end(), offsets.begin() + at);
+    std::copy(src.lengths.begin(), src.lengths.end(), lengths.begin() + at);
+    for (size_t i = 0; i < src.size(); i++)
+      lines[at + i] = src.lines[i] + line_delta;
+  }
+
+  size_t size() const { return kinds.size(); }
+  bool empty() const { return kinds.empty(); }
+
+  Token operator[](size_t i) const {
+    return Token(offsets[i], lengths[i], kind(i), lines[i]);
+  }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, size()); }
+
+  TokenType kind(size_t i) const { return static_cast<TokenType>(kinds[i]); }
+  uint32_t offset(size_t i) const { return offsets[i]; }
+  uint32_t length(size_t i) const { return lengths[i]; }
+  int line(size_t i) const { return lines[i]; }
+  std::string_view lexeme(size_t i, std::string_view source) const {
+    return source.substr(offsets[i], lengths[i]);
+  }
+
+  // Whole columns, for passes that scan one field.
+  const std::vector<int> &getLines() const { return lines; }
+
+private:
+  std::vector<uint8_t> kinds;
+  std::vector<uint32_t> offsets, lengths;
+  std::vector<int> lines;
+};
+
+// Encodes token i for the grammar's single-character terminals.
+inline char encodeTerminal(const TokenBuffer &tokens, size_t i,
+                           std::string_view source) {
+  return encodeTerminal(tokens.kind(i), tokens.lexeme(i, source));
+}
+
+#endif
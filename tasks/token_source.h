@@ -0,0 +1,193 @@
+#ifndef COMPILEWORK_TOKEN_SOURCE_H
+#define COMPILEWORK_TOKEN_SOURCE_H
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "lexer.h"
+#include "token_buffer.h"
+
+// Parser inputs. PredictTable::analysis and SLRParser::analysis take any type
+// with this shape:
+//
+//   const std::string &peek();  // terminal name of the lookahead, "#" at end
+//   void advance();             // consumes the lookahead
+//   int line();                 // source line of an error at the lookahead
+//   size_t position();          // where the lookahead is, for parse trees
+//   void print();               // writes the pending input for verbose traces
+//
+// and the expression mode of PredictTable also
+//
+//   std::string lexeme();       // source text of the lookahead
+
+// Lexes on demand and hands the parser one terminal at a time, so nothing is
+// materialised ahead of the parse. Tokens are kept from HISTORY places behind
+// the lookahead up to the furthest token asked for, which lets semantic
+// actions look around the current token.
+class TokenSource {
+public:
+  static constexpr size_t HISTORY = 2;
+
+  TokenSource(std::string_view source, LexerEngine engine = TABLE_ENGINE)
+      : source(source), lexer(source, engine), buffer(nullptr), next(0),
+        count(0), first(0), cur(0), last_line(0), ended(false),
+        has_terminal(false) {}
+  // Reads tokens lexed beforehand, e.g. by lexParallel.
+  TokenSource(std::string_view source, const TokenBuffer &tokens)
+      : source(source), lexer(std::string_view()), buffer(&tokens), next(0),
+        count(0), first(0), cur(0), last_line(0), ended(false),
+        has_terminal(false) {}
+
+  const std::string &peek() {
+    if (!has_terminal) {
+      Token t = token();
+      terminal =
+          t.type == END ? "#" : std::string(1, encodeTerminal(t, source));
+      has_terminal = true;
+    }
+    return terminal;
+  }
+
+  void advance() {
+    cur++;
+    has_terminal = false;
+    trim();
+  }
+
+  // The token k places from the lookahead; k may reach HISTORY places back.
+  // Past the end of input this is an empty END token.
+  Token token(long k = 0) {
+    size_t idx = cur + k;
+    if (k < 0 && static_cast<size_t>(-k) > cur)
+      throw std::runtime_error("Token before the start of input");
+    if (idx < first)
+      throw std::runtime_error("Token no longer buffered");
+    while (idx >= first + count) {
+      if (!pull())
+        return Token(source.size(), 0, END, last_line);
+    }
+    return at(idx);
+  }
+
+  std::string lexeme(long k = 0) {
+    return std::string(token(k).getLexeme(source));
+  }
+
+  // Number of tokens consumed so far.
+  size_t position() const { return cur; }
+
+  // An error at the lookahead is reported on the line of the token before
+  // it, which is where a missing token belongs.
+  int line() { return token(cur > 0 ? -1 : 0).getLineno(); }
+
+  std::string_view getSource() const { return source; }
+
+  void print() {
+    for (size_t i = cur; i < first + count; i++)
+      std::cout << encodeTerminal(at(i), source);
+    std::cout << (ended ? "#" : "...");
+  }
+
+private:
+  bool pull() {
+    if (ended)
+      return false;
+    if (buffer) {
+      if (next < buffer->size())
+        push((*buffer)[next++]);
+      else
+        ended = true;
+    } else {
+      TokenType type = lexer.getTokenType();
+      if (type == END)
+        ended = true;
+      else
+        push(lexer.buildToken(type));
+    }
+    if (ended)
+      return false;
+    last_line = at(first + count - 1).getLineno();
+    trim();
+    return true;
+  }
+
+  // The buffered tokens are a ring whose size is a power of two, token idx
+  // at idx & (size - 1), so it only allocates when the window outgrows it.
+  const Token &at(size_t idx) const {
+    return window[idx & (window.size() - 1)];
+  }
+
+  void push(const Token &token) {
+    if (count == window.size()) {
+      std::vector<Token> grown(std::max<size_t>(16, 2 * window.size()),
+                               Token(0, 0, END, 0));
+      for (size_t i = first; i < first + count; i++)
+        grown[i & (grown.size() - 1)] = at(i);
+      window.swap(grown);
+    }
+    window[(first + count++) & (window.size() - 1)] = token;
+  }
+
+  // Drops tokens more than HISTORY places behind the lookahead.
+  void trim() {
+    while (count > 0 && first + HISTORY < cur) {
+      count--;
+      first++;
+    }
+  }
+
+  std::string_view source;
+  Lexer lexer;
+  const TokenBuffer *buffer;
+  size_t next;
+  std::vector<Token> window;
+  size_t count, first, cur;
+  int last_line;
+  bool ended, has_terminal;
+  std::string terminal;
+};
+
+// Terminals spelled out in a string, one character each, with a trailing '
+// kept on the symbol before it.
+class StringInput {
+public:
+  StringInput(const std::string &str = "") : str(str), pos(0) { read(); }
+
+  const std::string &peek() const { return terminal; }
+
+  void advance() {
+    pos += terminal.size();
+    read();
+  }
+
+  int line() const { return 1; }
+
+  // A terminal is its own lexeme.
+  std::string lexeme() const { return terminal; }
+
+  // Characters consumed so far.
+  size_t position() const { return pos; }
+
+  void print() const { std::cout << str.substr(pos) << '#'; }
+
+private:
+  void read() {
+    if (pos >= str.size()) {
+      terminal = "#";
+      return;
+    }
+    terminal = str.substr(pos, 1);
+    if (pos + 1 < str.size() && str[pos + 1] == '\'')
+      terminal += '\'';
+  }
+
+  std::string str;
+  size_t pos;
+  std::string terminal;
+};
+
+#endif